@@ -0,0 +1,76 @@
+#include "arena.hpp"
+#include "bench.hpp"
+#include "fdm.hpp"
+#include "lattice.hpp"
+#include "trinomial.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <new>
+
+// every heap allocation in the bench binary goes through here so the pricing hot path can be checked for mallocs
+static std::atomic<long> allocations = 0;
+
+void *operator new(std::size_t n) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n, std::align_val_t a) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  std::size_t align = static_cast<std::size_t>(a);
+  if (void *p = std::aligned_alloc(align, (n + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+// gcc can't tell these replace the global operators above, and flags free() as mismatched
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// heap allocations and time per pricing with engine buffers on the heap against the thread's arena, after one
+// warm up call (which sizes the arena's blocks)
+void bench_allocations() {
+  AmericanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Put;
+  o.model = Model(2000, -1, 0.05f, 0.2f);
+  o.model.dt = o.expiration / o.model.steps;
+  o.model.dividends = {{0.5f, 1.5f, DividendType::Cash}};
+
+  std::cout << std::format("{:<20} {:>14} {:>14} {:>12} {:>12}\n", "engine", "heap allocs", "arena allocs", "heap (ms)", "arena (ms)");
+
+  auto measure = [](std::function<void()> f) {
+    f();
+    long before = allocations.load();
+    double ms = time_ms(f, 10);
+    return std::pair{(allocations.load() - before) / 10.0, ms};
+  };
+
+  std::tuple<const char *, std::function<void()>, std::function<void()>> engines[] = {
+      {"Binomial", [&] { rollback(o, Lattice(o.model, o.spot, o.strike)); }, [&] { o.price(Engine::Binomial); }},
+      {"Trinomial", [&] { rollback(o, Trinomial(o.model)); }, [&] { o.price(Engine::Trinomial); }},
+      {"Finite Difference", [&] { solve(o, FiniteDifference(o.model, o.spot)); }, [&] { o.price(Engine::FiniteDifference); }},
+  };
+
+  for (auto &[name, heap, arena] : engines) {
+    auto [heap_allocs, heap_ms] = measure(heap);
+    auto [arena_allocs, arena_ms] = measure(arena);
+    std::cout << std::format("{:<20} {:>14.1f} {:>14.1f} {:>12.3f} {:>12.3f}\n", name, heap_allocs, arena_allocs, heap_ms, arena_ms);
+    record({{"engine", name}}, {{"heap_allocs", heap_allocs}, {"arena_allocs", arena_allocs}, {"heap_time_ms", heap_ms}, {"arena_time_ms", arena_ms}});
+  }
+
+  std::cout << std::format("arena capacity {} KiB\n", Arena::local().capacity() / 1024);
+}
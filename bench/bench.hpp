@@ -0,0 +1,41 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include "blackscholes.hpp"
+#include "nlohmann/json.hpp"
+#include "options.hpp"
+#include <chrono>
+#include <cmath>
+
+// benchmarks, each prints its results to stdout
+void bench_convergence();
+void bench_pruning();
+void bench_greeks();
+void bench_precision();
+void bench_kernels();
+void bench_allocations();
+void bench_cache();
+void bench_throughput();
+void bench_io();
+void bench_trees();
+void bench_boundary();
+void bench_controlvariate();
+void bench_rainbow();
+void bench_planner();
+void bench_numa();
+
+// machine readable result for the running benchmark, params identify the case (engine, steps, ...) and
+// metrics hold what was measured, bopm_bench --json <file> writes them one per line so runs can be diffed
+void record(nlohmann::json params, nlohmann::json metrics);
+
+// mean wall time of f over reps runs (ms)
+template <typename F> double time_ms(F f, int reps = 1) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) {
+    f();
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / reps;
+}
+
+#endif
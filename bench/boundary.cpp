@@ -0,0 +1,43 @@
+#include "bench.hpp"
+#include "boundary.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// american repricing against a cached exercise boundary (early exercise premium integral) after spot and vol
+// moves, error and time against a full rollback at the moved spot and vol
+void bench_boundary() {
+  std::cout << std::format("{:<6} {:>8} {:>8} {:>14} {:>14} {:>12} {:>10}\n", "side", "spot", "vol", "rollback (ms)", "boundary (ms)", "abs error",
+                           "speedup");
+
+  for (Side side : {Side::Put, Side::Call}) {
+    AmericanOption o;
+    o.spot = 100;
+    o.strike = 100;
+    o.expiration = 1;
+    o.side = side;
+    o.model = Model(2000, o.expiration, 0.05f, 0.2f);
+    o.model.yield = side == Side::Call ? 0.08f : 0;
+
+    BoundaryPricer pricer(o);
+
+    for (auto [spot, shift] : {std::pair{100.f, 0.f}, {101.f, 0.f}, {97.f, 0.f}, {105.f, 0.f}, {100.f, 0.005f}, {100.f, -0.01f}}) {
+      AmericanOption moved = o;
+      moved.spot = spot;
+      for (float &v : moved.model.vols) {
+        v += shift;
+      }
+
+      double ref;
+      double rollback_ms = time_ms([&] { ref = rollback(moved, BasicLattice<double>(moved.model, moved.spot, moved.strike)); }, 3);
+
+      double price;
+      double boundary_ms = time_ms([&] { price = pricer.price(spot, shift); }, 100);
+
+      std::cout << std::format("{:<6} {:>8.1f} {:>8.3f} {:>14.4f} {:>14.4f} {:>12.6f} {:>10.0f}\n", side_str(side), spot, 0.2 + shift, rollback_ms,
+                               boundary_ms, std::abs(price - ref), rollback_ms / boundary_ms);
+      record({{"side", side_str(side)}, {"spot", spot}, {"vol_shift", shift}},
+             {{"rollback_time_ms", rollback_ms}, {"boundary_time_ms", boundary_ms}, {"abs_error", std::abs(price - ref)}});
+    }
+  }
+}
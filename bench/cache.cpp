@@ -0,0 +1,56 @@
+#include "bench.hpp"
+#include "cache.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// repricing one model over a run of spot ticks, building the lattice every time against sharing it through
+// the lattice cache, both on the model's default double lattice
+void bench_cache() {
+  AmericanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Put;
+
+  std::cout << std::format("{:<8} {:>8} {:>12} {:>12} {:>14} {:>14} {:>8} {:>8}\n", "param", "steps", "setup (ms)", "lookup (ms)", "built (ms)",
+                           "cached (ms)", "hits", "misses");
+
+  for (Param p : {Param::CRR, Param::LR}) {
+    for (int steps : {100, 500, 2000}) {
+      o.model = Model(steps, -1, 0.05f, 0.2f);
+      o.model.dt = o.expiration / steps;
+      o.model.param = p;
+      o.model.dividends = {{0.5f, 1.5f, DividendType::Cash}};
+
+      LatticeCache &c = LatticeCache::global();
+      c.clear();
+
+      // setup alone, then full reprices over the ticks
+      int ticks = 50;
+      double setup = time_ms([&] { Lattice(o.model, o.spot, o.strike); }, ticks);
+      double lookup = time_ms([&] { c.get<double>(o.model, o.spot, o.strike); }, ticks);
+      c.clear();
+
+      double built = time_ms([&] {
+        for (int t = 0; t < ticks; t++) {
+          o.spot = 100 + 0.01f * t;
+          rollback(o, Lattice(o.model, o.spot, o.strike));
+        }
+      });
+      double cached = time_ms([&] {
+        for (int t = 0; t < ticks; t++) {
+          o.spot = 100 + 0.01f * t;
+          o.price(Engine::Binomial);
+        }
+      });
+
+      std::cout << std::format("{:<8} {:>8} {:>12.4f} {:>12.4f} {:>14.3f} {:>14.3f} {:>8} {:>8}\n", param_str(p), steps, setup, lookup, built / ticks,
+                               cached / ticks, c.hits(), c.misses());
+      record({{"param", param_str(p)}, {"steps", steps}},
+             {{"setup_time_ms", setup}, {"lookup_time_ms", lookup}, {"built_time_ms", built / ticks}, {"cached_time_ms", cached / ticks}});
+    }
+  }
+
+  o.spot = 100;
+}
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+# compares two bopm_bench --json runs, flagging timings that slowed and errors that grew beyond a tolerance
+#
+#   python3 bench/compare.py base.jsonl head.jsonl [--tolerance 0.1]
+#
+# exits non-zero if anything regressed, so it can gate a change
+
+import argparse
+import json
+import sys
+
+
+def load(fn):
+    results = {}
+    with open(fn) as f:
+        for line in f:
+            r = json.loads(line)
+            results[(r["bench"], json.dumps(r["params"], sort_keys=True))] = r["metrics"]
+    return results
+
+
+def worse(metric, base, head, tol):
+    # throughputs are better higher, everything else (times, errors, allocations, sizes) better lower
+    if metric.endswith("per_s"):
+        return head < base * (1 - tol)
+    return head > base * (1 + tol) and head - base > 1e-9
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument("base")
+parser.add_argument("head")
+parser.add_argument("--tolerance", type=float, default=0.1)
+args = parser.parse_args()
+
+base, head = load(args.base), load(args.head)
+regressions = 0
+
+for key in sorted(base.keys() & head.keys()):
+    for metric, b in sorted(base[key].items()):
+        h = head[key].get(metric)
+        if h is None:
+            continue
+
+        change = (h - b) / b if b else 0
+        flag = worse(metric, b, h, args.tolerance)
+        regressions += flag
+
+        if flag or abs(change) > args.tolerance:
+            print(f"{'REGRESSED' if flag else 'improved':<10} {key[0]:<12} {key[1]:<60} {metric:<18} {b:>12.6g} -> {h:<12.6g} ({change:+.1%})")
+
+for key in sorted(base.keys() - head.keys()):
+    print(f"{'missing':<10} {key[0]:<12} {key[1]}")
+
+print(f"{regressions} regressions across {len(base.keys() & head.keys())} cases")
+sys.exit(1 if regressions else 0)
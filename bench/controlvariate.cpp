@@ -0,0 +1,46 @@
+#include "bench.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// error against time of plain american lattice prices and prices corrected with the european control variate,
+// the reference is the mean of two deep double lattices one step apart (cancelling the odd / even oscillation)
+//
+// both parities are run, the plain lattice oscillates between them while the corrected price (smoothed over the
+// last step) should not
+void bench_controlvariate() {
+  std::cout << std::format("{:<8} {:>8} {:>12} {:>14} {:>12} {:>14}\n", "spot", "steps", "plain (ms)", "plain error", "cv (ms)", "cv error");
+
+  for (float spot : {90.f, 100.f, 110.f}) {
+    AmericanOption o;
+    o.spot = spot;
+    o.strike = 100;
+    o.expiration = 1;
+    o.side = Side::Put;
+
+    auto at = [&](int steps) {
+      o.model = Model(steps, -1, 0.05f, 0.2f);
+      o.model.dt = o.expiration / steps;
+    };
+
+    at(20000);
+    double ref = rollback(o, BasicLattice<double>(o.model, o.spot, o.strike));
+    at(20001);
+    ref = (ref + rollback(o, BasicLattice<double>(o.model, o.spot, o.strike))) / 2;
+
+    for (int steps : {50, 51, 200, 201, 800, 801, 3200, 3201}) {
+      at(steps);
+      BasicLattice<double> l(o.model, o.spot, o.strike);
+
+      // the closed form is part of the cost of the corrected price
+      double plain, cv;
+      double plain_ms = time_ms([&] { plain = rollback(o, l); }, 20);
+      double cv_ms = time_ms([&] { cv = rollback_cv(o, l, black_scholes(o, o.model)); }, 20);
+
+      std::cout << std::format("{:<8.1f} {:>8} {:>12.4f} {:>14.6f} {:>12.4f} {:>14.6f}\n", spot, steps, plain_ms, std::abs(plain - ref), cv_ms,
+                               std::abs(cv - ref));
+      record({{"spot", spot}, {"steps", steps}},
+             {{"plain_time_ms", plain_ms}, {"plain_abs_error", std::abs(plain - ref)}, {"cv_time_ms", cv_ms}, {"cv_abs_error", std::abs(cv - ref)}});
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "fdm.hpp"
+#include "lattice.hpp"
+#include "trinomial.hpp"
+#include <format>
+#include <iostream>
+
+// error against black-scholes and time per price for each parameterisation (and the trinomial and finite difference engines) as steps increase
+void bench_convergence() {
+  EuropeanOption o;
+  o.spot = 100;
+  o.strike = 105;
+  o.expiration = 1;
+  o.side = Side::Call;
+
+  float r = 0.05, v = 0.2;
+  double ref = black_scholes(o, r, 0, v);
+
+  std::cout << std::format("{:<8} {:>8} {:>14} {:>12}\n", "param", "steps", "abs error", "time (ms)");
+
+  for (Param p : {Param::CRR, Param::JR, Param::Tian, Param::LR}) {
+    for (int steps : {25, 51, 101, 201, 401, 801, 1601}) {
+      o.model = Model(steps, -1, r, v);
+      o.model.dt = o.expiration / steps;
+      o.model.param = p;
+
+      // double lattice (the library default), float rounding would swamp the discretisation error being measured
+      double price;
+      double ms = time_ms([&] { price = rollback(o, BasicLattice<double>(o.model, o.spot, o.strike)); }, 20);
+
+      std::cout << std::format("{:<8} {:>8} {:>14.8f} {:>12.4f}\n", param_str(p), steps, std::abs(price - ref), ms);
+      record({{"engine", "Binomial"}, {"param", param_str(p)}, {"steps", steps}}, {{"abs_error", std::abs(price - ref)}, {"time_ms", ms}});
+    }
+  }
+
+  for (int steps : {25, 51, 101, 201, 401, 801, 1601}) {
+    o.model = Model(steps, -1, r, v);
+    o.model.dt = o.expiration / steps;
+
+    float price;
+    double ms = time_ms([&] { price = rollback(o, Trinomial(o.model)); }, 20);
+
+    std::cout << std::format("{:<8} {:>8} {:>14.8f} {:>12.4f}\n", "Tri", steps, std::abs(price - ref), ms);
+    record({{"engine", "Trinomial"}, {"steps", steps}}, {{"abs_error", std::abs(price - ref)}, {"time_ms", ms}});
+  }
+
+  for (int steps : {25, 51, 101, 201, 401, 801, 1601}) {
+    o.model = Model(steps, -1, r, v);
+    o.model.dt = o.expiration / steps;
+
+    float price;
+    double ms = time_ms([&] { price = solve(o, FiniteDifference(o.model, o.spot)).price; }, 20);
+
+    std::cout << std::format("{:<8} {:>8} {:>14.8f} {:>12.4f}\n", "FD", steps, std::abs(price - ref), ms);
+    record({{"engine", "Finite Difference"}, {"steps", steps}}, {{"abs_error", std::abs(price - ref)}, {"time_ms", ms}});
+  }
+}
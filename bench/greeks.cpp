@@ -0,0 +1,47 @@
+#include "aad.hpp"
+#include "bench.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// cost of every first order sensitivity (spot, strike, expiration, yield, each step's rate and vol) by one
+// adjoint sweep, against bump and reprice with central differences
+void bench_greeks() {
+  AmericanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Put;
+
+  std::cout << std::format("{:<8} {:>8} {:>14} {:>14} {:>14} {:>10}\n", "steps", "inputs", "price (ms)", "adjoint (ms)", "bump (ms)",
+                           "adj/price");
+
+  for (int steps : {50, 100, 200, 400}) {
+    o.model = Model(steps, -1, 0.05f, 0.2f);
+    o.model.dt = o.expiration / steps;
+    int inputs = 2 * steps + 4;
+
+    double price_ms = time_ms([&] { rollback(o, Lattice(o.model, o.spot, o.strike)); }, 10);
+    double adj_ms = time_ms([&] { adjoint(o, o.model); }, 10);
+
+    // two reprices per input, bumping each step's rate and vol in turn
+    double bump_ms = time_ms([&] {
+      for (int i = 0; i < inputs; i++) {
+        for (float h : {1e-3f, -1e-3f}) {
+          Model m = o.model;
+          if (i < steps) {
+            m.rates[i] += h;
+          } else if (i < 2 * steps) {
+            m.vols[i - steps] += h;
+          } else {
+            m.yield += h; // stands in for spot, strike, expiration and yield, same cost
+          }
+          rollback(o, Lattice(m, o.spot, o.strike));
+        }
+      }
+    });
+
+    std::cout << std::format("{:<8} {:>8} {:>14.4f} {:>14.4f} {:>14.4f} {:>10.2f}\n", steps, inputs, price_ms, adj_ms, bump_ms, adj_ms / price_ms);
+    record({{"steps", steps}}, {{"price_time_ms", price_ms}, {"adjoint_time_ms", adj_ms}, {"bump_time_ms", bump_ms}});
+  }
+}
@@ -0,0 +1,34 @@
+#include "bench.hpp"
+#include "rw.hpp"
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+// model file round trip, split into the file read, json parse and Model::from_json (which rebuilds the
+// branches), and the reverse for saving
+void bench_io() {
+  std::string fn = (std::filesystem::temp_directory_path() / "bopm_bench_model.json").string();
+
+  std::cout << std::format("{:<8} {:>10} {:>12} {:>12} {:>12} {:>12}\n", "steps", "bytes", "read (ms)", "parse (ms)", "load (ms)", "save (ms)");
+
+  for (int steps : {100, 1000, 10000}) {
+    Model m(steps, 1, 0.05f, 0.2f);
+    m.dividends = {{0.25f, 1.f, DividendType::Cash}, {0.75f, 0.01f, DividendType::Proportional}};
+    write_file(fn, m.to_json().dump(2));
+
+    std::string text;
+    nlohmann::json data;
+    Model loaded;
+
+    double read_ms = time_ms([&] { text = read_file(fn); }, 20);
+    double parse_ms = time_ms([&] { data = nlohmann::json::parse(text); }, 20);
+    double load_ms = time_ms([&] { loaded.from_json(data); }, 20);
+    double save_ms = time_ms([&] { write_file(fn, m.to_json().dump(2)); }, 20);
+
+    std::cout << std::format("{:<8} {:>10} {:>12.4f} {:>12.4f} {:>12.4f} {:>12.4f}\n", steps, text.size(), read_ms, parse_ms, load_ms, save_ms);
+    record({{"steps", steps}}, {{"bytes", text.size()}, {"read_time_ms", read_ms}, {"parse_time_ms", parse_ms}, {"load_time_ms", load_ms},
+                                {"save_time_ms", save_ms}});
+  }
+
+  std::filesystem::remove(fn);
+}
@@ -0,0 +1,42 @@
+#include "bench.hpp"
+#include "lattice.hpp"
+#include "trinomial.hpp"
+#include <format>
+#include <iostream>
+
+// throughput of each compile time specialised rollback kernel (exercise style x side, per engine and precision)
+void bench_kernels() {
+  std::cout << std::format("{:<10} {:<10} {:<6} {:<8} {:>8} {:>12} {:>12}\n", "engine", "type", "side", "scalar", "steps", "time (ms)", "Mnodes/s");
+
+  for (int steps : {2000, 8000}) {
+    Model m(steps, -1, 0.05f, 0.2f);
+    m.dt = 1.f / steps;
+
+    BasicLattice<float> lf(m, 100, 100);
+    BasicLattice<double> ld(m, 100, 100);
+    Trinomial tri(m);
+
+    for (Type type : {Type::European, Type::American}) {
+      for (Side side : {Side::Call, Side::Put}) {
+        Option o = type == Type::European ? (Option)EuropeanOption() : (Option)AmericanOption();
+        o.spot = 100;
+        o.strike = 100;
+        o.expiration = 1;
+        o.side = side;
+
+        double bin = (steps + 1.0) * (steps + 2) / 2, trin = (steps + 1.0) * (steps + 1);
+        double tf = time_ms([&] { rollback(o, lf); }, 5);
+        double td = time_ms([&] { rollback(o, ld); }, 5);
+        double tt = time_ms([&] { rollback(o, tri); }, 5);
+
+        for (auto [engine, scalar, ms, nodes] : {std::tuple{"Binomial", "float", tf, bin}, std::tuple{"Binomial", "double", td, bin},
+                                                 std::tuple{"Trinomial", "float", tt, trin}}) {
+          std::cout << std::format("{:<10} {:<10} {:<6} {:<8} {:>8} {:>12.3f} {:>12.1f}\n", engine, type_str(type), side_str(side), scalar, steps, ms,
+                                   nodes / ms / 1e3);
+          record({{"engine", engine}, {"type", type_str(type)}, {"side", side_str(side)}, {"scalar", scalar}, {"steps", steps}},
+                 {{"time_ms", ms}, {"mnodes_per_s", nodes / ms / 1e3}});
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+static std::string running;
+static std::vector<nlohmann::json> results;
+
+void record(nlohmann::json params, nlohmann::json metrics) { results.push_back({{"bench", running}, {"params", params}, {"metrics", metrics}}); }
+
+int main(int argc, char **argv) {
+  std::map<std::string, std::function<void()>> benches{{"convergence", bench_convergence}, {"pruning", bench_pruning}, {"greeks", bench_greeks},
+                                                       {"precision", bench_precision},     {"kernels", bench_kernels}, {"allocations", bench_allocations},
+                                                       {"cache", bench_cache},             {"throughput", bench_throughput}, {"io", bench_io},
+                                                       {"trees", bench_trees},             {"boundary", bench_boundary},
+                                                       {"controlvariate", bench_controlvariate}, {"rainbow", bench_rainbow},
+                                                       {"planner", bench_planner},         {"numa", bench_numa}};
+
+  // bopm_bench [--json <file>] [bench ...], runs the named benchmarks or all of them
+  std::string json_path;
+  std::vector<std::string> names;
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--json" && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      names.push_back(argv[i]);
+    }
+  }
+
+  for (auto &[name, bench] : benches) {
+    bool selected = names.empty();
+    for (std::string &n : names) {
+      selected |= name == n;
+    }
+
+    if (selected) {
+      std::cout << "== " << name << " ==\n";
+      running = name;
+      bench();
+      std::cout << "\n";
+    }
+  }
+
+  // one result per line in a fixed order (benches by name, cases as run, keys sorted), compare two runs
+  // with bench/compare.py
+  if (!json_path.empty()) {
+    std::ofstream out(json_path);
+    for (nlohmann::json &r : results) {
+      out << r.dump() << '\n';
+    }
+  }
+
+  return 0;
+}
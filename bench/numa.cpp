@@ -0,0 +1,133 @@
+#include "arena.hpp"
+#include "bench.hpp"
+#include "cache.hpp"
+#include "lattice.hpp"
+#include "pool.hpp"
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+std::string pages_str(Arena::Pages p) {
+  if (p == Arena::Pages::Heap) {
+    return "Heap";
+  } else if (p == Arena::Pages::Transparent) {
+    return "Transparent";
+  } else {
+    return "Explicit";
+  }
+}
+
+// anonymous memory of the process currently backed by huge pages (kb)
+long huge_kb() {
+  std::ifstream in("/proc/self/smaps_rollup");
+  std::string key;
+  long kb;
+  while (in >> key) {
+    if (key == "AnonHugePages:" && in >> kb) {
+      return kb;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+// arena page backing and batch thread placement
+//
+// deep single options are priced on a fresh thread per page policy (so its arena maps new blocks), timing the
+// second pricing once blocks are held, the 1d lattices only need a few mb of scratch even at 50k steps, the 2d
+// slices are where the tlb starts to matter, then 100k short american options are priced on one thread, on an
+// unpinned pool and on the pinned pool
+void bench_numa() {
+  std::vector<std::vector<int>> nodes = numa_nodes();
+  std::cout << std::format("{} numa nodes, {} cpus\n\n", nodes.size(), std::thread::hardware_concurrency());
+
+  std::cout << std::format("{:<12} {:<10} {:>8} {:>12} {:>14}\n", "pages", "lattice", "steps", "time (ms)", "huge pages (mb)");
+
+  for (Arena::Pages pages : {Arena::Pages::Heap, Arena::Pages::Transparent, Arena::Pages::Explicit}) {
+    Arena::set_pages(pages);
+
+    auto run = [&](std::string lattice, int steps, auto price) {
+      double ms;
+      long kb;
+      std::thread([&] {
+        price();
+        ms = time_ms(price);
+        kb = huge_kb();
+      }).join();
+
+      std::cout << std::format("{:<12} {:<10} {:>8} {:>12.3f} {:>14.1f}\n", pages_str(pages), lattice, steps, ms, kb / 1024.0);
+      record({{"case", "pages"}, {"pages", pages_str(pages)}, {"lattice", lattice}, {"steps", steps}}, {{"time_ms", ms}, {"huge_pages_mb", kb / 1024.0}});
+    };
+
+    for (int steps : {20000, 50000}) {
+      AmericanOption o;
+      o.spot = 100;
+      o.strike = 100;
+      o.expiration = 1;
+      o.side = Side::Put;
+      o.model = Model(steps, -1, 0.05f, 0.2f);
+      o.model.dt = o.expiration / steps;
+      BasicLattice<double> l(o.model, o.spot, o.strike);
+
+      run("Binomial", steps, [&] { rollback(o, l); });
+    }
+
+    for (int steps : {1000, 1500}) {
+      RainbowOption o;
+      o.spot = {100, 95};
+      o.strike = 5;
+      o.expiration = 1;
+      o.type = Type::American;
+      o.side = Side::Put;
+      o.payoff = RainbowPayoff::Spread;
+      o.correlation = 0.5;
+      for (Model &m : o.model) {
+        m = Model(steps, -1, 0.05f, 0.2f);
+        m.dt = o.expiration / steps;
+      }
+
+      run("2D", steps, [&] { o.price(); });
+    }
+  }
+  Arena::set_pages(Arena::Pages::Transparent);
+
+  std::cout << std::format("\n{:<16} {:>8} {:>10} {:>12} {:>14}\n", "batch", "options", "threads", "time (ms)", "prices/s");
+
+  int count = 100000;
+  std::vector<AmericanOption> book(count);
+  std::vector<Option *> options;
+  for (int i = 0; i < count; i++) {
+    AmericanOption &o = book[i];
+    o.spot = 100;
+    o.strike = 80 + 40.f * i / count;
+    o.expiration = 1;
+    o.side = i % 2 ? Side::Call : Side::Put;
+    o.model = Model(100, -1, 0.05f, 0.2f);
+    o.model.dt = o.expiration / 100;
+    options.push_back(&o);
+  }
+
+  auto batch = [&](std::string name, int threads, auto f) {
+    LatticeCache::global().clear();
+    f();
+    double ms = time_ms(f);
+
+    std::cout << std::format("{:<16} {:>8} {:>10} {:>12.1f} {:>14.0f}\n", name, count, threads, ms, count / ms * 1e3);
+    record({{"case", "batch"}, {"batch", name}, {"options", count}, {"threads", threads}}, {{"time_ms", ms}, {"prices_per_s", count / ms * 1e3}});
+  };
+
+  batch("single thread", 1, [&] {
+    for (Option *o : options) {
+      o->price();
+    }
+  });
+
+  ThreadPool unpinned(0, false), pinned(0, true);
+  batch("pool, unpinned", unpinned.size(), [&] { price_batch(options, unpinned); });
+  batch("pool, pinned", pinned.size(), [&] { price_batch(options, pinned); });
+  std::cout << std::format("\n{} of {} workers pinned\n", pinned.pinned(), pinned.size());
+}
@@ -0,0 +1,62 @@
+#include "bench.hpp"
+#include "planner.hpp"
+#include <format>
+#include <iostream>
+
+// planner estimates against measurement, runtime and error of an american put on each engine as predicted
+// from the calibration run and the option's prices at small step counts, then the time to price at the plan
+// for a few accuracy targets
+void bench_planner() {
+  AmericanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Put;
+  o.model = Model(500, -1, 0.05f, 0.2f);
+  o.model.dt = o.expiration / 500;
+  o.model.precision = Precision::Double;
+
+  // mean of two deep lattices one step apart, cancelling the odd / even oscillation
+  AmericanOption deep = o;
+  deep.model = o.model.resample(20000);
+  double ref = deep.price(Engine::Binomial);
+  deep.model = o.model.resample(20001);
+  ref = (ref + deep.price(Engine::Binomial)) / 2;
+
+  std::cout << std::format("{:<18} {:>8} {:>14} {:>12} {:>14} {:>12}\n", "engine", "steps", "estimate (ms)", "actual (ms)", "est. error",
+                           "abs error");
+
+  for (Engine e : {Engine::Binomial, Engine::Trinomial, Engine::FiniteDifference}) {
+    for (int steps : {1000, 4000}) {
+      Estimate est = estimate(o, e, steps);
+
+      AmericanOption priced = o;
+      priced.model = o.model.resample(steps);
+      double price;
+      double ms = time_ms([&] { price = priced.price(e); });
+
+      std::cout << std::format("{:<18} {:>8} {:>14.3f} {:>12.3f} {:>14.2g} {:>12.2g}\n", engine_str(e), steps, est.ms, ms, est.error,
+                               std::abs(price - ref));
+      record({{"case", "estimate"}, {"engine", engine_str(e)}, {"steps", steps}},
+             {{"estimate_ms", est.ms}, {"time_ms", ms}, {"estimate_error", est.error}, {"abs_error", std::abs(price - ref)}});
+    }
+  }
+
+  std::cout << std::format("\n{:<10} {:<18} {:>8} {:>12} {:>12}\n", "accuracy", "engine", "steps", "time (ms)", "abs error");
+
+  for (double accuracy : {1e-2, 1e-3, 1e-4}) {
+    double plan_ms;
+    Estimate est;
+    plan_ms = time_ms([&] { est = plan(o, accuracy); });
+
+    AmericanOption priced = o;
+    priced.model = o.model.resample(est.steps);
+    double price;
+    double ms = time_ms([&] { price = priced.price(est.engine); });
+
+    std::cout << std::format("{:<10.0e} {:<18} {:>8} {:>12.3f} {:>12.2g}\n", accuracy, engine_str(est.engine), est.steps, plan_ms + ms,
+                             std::abs(price - ref));
+    record({{"case", "plan"}, {"accuracy", accuracy}},
+           {{"engine", engine_str(est.engine)}, {"steps", est.steps}, {"plan_time_ms", plan_ms}, {"time_ms", ms}, {"abs_error", std::abs(price - ref)}});
+  }
+}
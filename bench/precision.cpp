@@ -0,0 +1,37 @@
+#include "bench.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// throughput against accuracy of float and double lattices, rounding error is measured against the
+// double lattice with the same steps (so discretisation error cancels) and total error against black-scholes
+void bench_precision() {
+  EuropeanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Call;
+
+  double ref = black_scholes(o, 0.05, 0, 0.2);
+
+  std::cout << std::format("{:<8} {:>8} {:>14} {:>14} {:>12} {:>14}\n", "mode", "steps", "rounding", "total error", "time (ms)", "Mnodes/s");
+
+  for (int steps : {1000, 4000, 16000}) {
+    o.model = Model(steps, -1, 0.05f, 0.2f);
+    o.model.dt = o.expiration / steps;
+    double nodes = (steps + 1.0) * (steps + 2) / 2;
+
+    BasicLattice<float> lf(o.model, o.spot, o.strike);
+    BasicLattice<double> ld(o.model, o.spot, o.strike);
+
+    double pd, pf;
+    double td = time_ms([&] { pd = rollback(o, ld); }, 3);
+    double tf = time_ms([&] { pf = rollback(o, lf); }, 3);
+
+    for (auto [mode, price, ms] : {std::tuple{"Float", pf, tf}, std::tuple{"Double", pd, td}}) {
+      std::cout << std::format("{:<8} {:>8} {:>14.8f} {:>14.8f} {:>12.3f} {:>14.1f}\n", mode, steps, std::abs(price - pd), std::abs(price - ref), ms,
+                               nodes / ms / 1e3);
+      record({{"mode", mode}, {"steps", steps}}, {{"rounding", std::abs(price - pd)}, {"abs_error", std::abs(price - ref)}, {"time_ms", ms}});
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#include "bench.hpp"
+#include "lattice.hpp"
+#include <format>
+#include <iostream>
+
+// nodes rolled back, time and price difference of a pruned 10,000 step lattice against the full lattice
+void bench_pruning() {
+  AmericanOption o;
+  o.spot = 100;
+  o.strike = 100;
+  o.expiration = 1;
+  o.side = Side::Put;
+
+  int steps = 10000;
+  o.model = Model(steps, -1, 0.05f, 0.2f);
+  o.model.dt = o.expiration / steps;
+
+  Lattice full(o.model, o.spot, o.strike);
+  float ref;
+  double ref_ms = time_ms([&] { ref = rollback(o, full); }, 3);
+
+  std::cout << std::format("{:<8} {:>12} {:>12} {:>14} {:>14}\n", "k", "nodes", "time (ms)", "abs error", "bound");
+  std::cout << std::format("{:<8} {:>12} {:>12.3f} {:>14.8f} {:>14.8f}\n", "full", full.nodes(), ref_ms, 0.0, 0.0);
+  record({{"k", 0}}, {{"nodes", full.nodes()}, {"time_ms", ref_ms}, {"abs_error", 0}});
+
+  for (float k : {8.f, 6.f, 5.f, 4.f, 3.f}) {
+    o.model.prune = k;
+    Lattice l(o.model, o.spot, o.strike);
+
+    float price;
+    double ms = time_ms([&] { price = rollback(o, l); }, 3);
+
+    std::cout << std::format("{:<8} {:>12} {:>12.3f} {:>14.8f} {:>14.8f}\n", k, l.nodes(), ms, std::abs(price - ref),
+                             l.truncation_bound(o.spot, o.strike));
+    record({{"k", k}}, {{"nodes", l.nodes()}, {"time_ms", ms}, {"abs_error", std::abs(price - ref)}});
+  }
+}
@@ -0,0 +1,67 @@
+#include "bench.hpp"
+#include "lattice2d.hpp"
+#include "pool.hpp"
+#include <format>
+#include <iostream>
+
+namespace {
+
+RainbowOption rainbow(Type type, Side side, RainbowPayoff payoff, int steps) {
+  RainbowOption o;
+  o.spot = {100, 95};
+  o.strike = 0;
+  o.expiration = 1;
+  o.type = type;
+  o.side = side;
+  o.payoff = payoff;
+  o.correlation = 0.5;
+  o.model[0] = Model(steps, o.expiration, 0.05f, 0.2f);
+  o.model[1] = Model(steps, o.expiration, 0.05f, 0.3f);
+  o.model[1].yield = 0.02f;
+  return o;
+}
+
+// margrabe's price of the option to exchange the second underlying for the first
+double margrabe(const RainbowOption &o) {
+  double t = o.expiration, v1 = o.model[0].vols[0], v2 = o.model[1].vols[0];
+  double f1 = o.spot[0] * std::exp(-o.model[0].yield * t), f2 = o.spot[1] * std::exp(-o.model[1].yield * t);
+  double sd = std::sqrt((v1 * v1 + v2 * v2 - 2 * o.correlation * v1 * v2) * t);
+  double d1 = std::log(f1 / f2) / sd + sd / 2;
+  return f1 * norm_cdf(d1) - f2 * norm_cdf(d1 - sd);
+}
+
+} // namespace
+
+// two asset lattice, convergence of a european exchange option (spread call struck at 0) to margrabe's closed
+// form, then rollback throughput of an american spread put across thread counts
+void bench_rainbow() {
+  std::cout << std::format("{:<8} {:>12} {:>12} {:>12}\n", "steps", "price", "abs error", "time (ms)");
+
+  for (int steps : {50, 100, 200, 400, 800}) {
+    RainbowOption o = rainbow(Type::European, Side::Call, RainbowPayoff::Spread, steps);
+    double ref = margrabe(o);
+
+    double price;
+    double ms = time_ms([&] { price = o.price(); });
+
+    std::cout << std::format("{:<8} {:>12.6f} {:>12.6f} {:>12.3f}\n", steps, price, std::abs(price - ref), ms);
+    record({{"case", "margrabe"}, {"steps", steps}}, {{"abs_error", std::abs(price - ref)}, {"time_ms", ms}});
+  }
+
+  std::cout << std::format("\n{:<8} {:>8} {:>12} {:>12} {:>10}\n", "steps", "threads", "time (ms)", "Mnodes/s", "speedup");
+
+  int steps = 1500;
+  RainbowOption o = rainbow(Type::American, Side::Put, RainbowPayoff::Spread, steps);
+  o.strike = 5;
+  Lattice2D l(o);
+
+  double single = 0;
+  int hw = ThreadPool::global().size();
+  for (int threads = 1; threads <= hw; threads *= 2) {
+    double ms = time_ms([&] { rollback(o, l, threads); });
+    single = threads == 1 ? ms : single;
+
+    std::cout << std::format("{:<8} {:>8} {:>12.3f} {:>12.1f} {:>10.2f}\n", steps, threads, ms, l.nodes() / ms / 1e3, single / ms);
+    record({{"case", "threads"}, {"steps", steps}, {"threads", threads}}, {{"time_ms", ms}, {"mnodes_per_s", l.nodes() / ms / 1e3}});
+  }
+}
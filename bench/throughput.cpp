@@ -0,0 +1,47 @@
+#include "bench.hpp"
+#include "cache.hpp"
+#include <format>
+#include <iostream>
+#include <memory>
+
+// prices per second through Option::price, as the ui and pricing service call it, across option types, engines
+// and step counts (asian options enumerate every path, so are run at far fewer steps)
+void bench_throughput() {
+  std::cout << std::format("{:<10} {:<20} {:>8} {:>12} {:>14}\n", "type", "engine", "steps", "time (ms)", "prices/s");
+
+  auto run = [](Option &o, Engine e, int steps, int reps) {
+    o.spot = 100;
+    o.strike = 100;
+    o.expiration = 1;
+    o.side = Side::Put;
+    o.model = Model(steps, -1, 0.05f, 0.2f);
+    o.model.dt = o.expiration / steps;
+    o.model.update_branches();
+
+    LatticeCache::global().clear();
+    double ms = time_ms([&] { o.price(e); }, reps);
+
+    std::cout << std::format("{:<10} {:<20} {:>8} {:>12.4f} {:>14.1f}\n", type_str(o.type), engine_str(e), steps, ms, 1e3 / ms);
+    record({{"type", type_str(o.type)}, {"engine", engine_str(e)}, {"steps", steps}}, {{"time_ms", ms}, {"prices_per_s", 1e3 / ms}});
+  };
+
+  for (Type type : {Type::European, Type::American}) {
+    for (Engine e : {Engine::Binomial, Engine::Trinomial, Engine::FiniteDifference}) {
+      for (int steps : {100, 500, 2000}) {
+        std::unique_ptr<Option> o;
+        if (type == Type::European) {
+          o = std::make_unique<EuropeanOption>();
+        } else {
+          o = std::make_unique<AmericanOption>();
+        }
+        run(*o, e, steps, steps < 2000 ? 50 : 5);
+      }
+    }
+  }
+
+  for (int steps : {8, 12, 16}) {
+    AsianOption o;
+    o.payoff_type = PayoffType::Fixed;
+    run(o, Engine::Binomial, steps, 5);
+  }
+}
@@ -0,0 +1,53 @@
+#include "bench.hpp"
+#include "plotdata.hpp"
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+// plot preparation, the full value tree serialised to json (as the plots used to be fed) against the
+// downsampled plot data written as binary arrays, which also carries values, deltas and thetas
+void bench_trees() {
+  std::string fn = (std::filesystem::temp_directory_path() / "bopm_bench_plot.bin").string();
+
+  std::cout << std::format("{:<8} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n", "steps", "json bytes", "tree (ms)", "json (ms)", "plot bytes",
+                           "build (ms)", "write (ms)");
+
+  for (int steps : {100, 500, 2000}) {
+    AmericanOption o;
+    o.spot = 100;
+    o.strike = 100;
+    o.expiration = 1;
+    o.side = Side::Put;
+    o.model = Model(steps, o.expiration, 0.05f, 0.2f);
+    o.model.update_branches();
+
+    std::vector<std::vector<float>> tree;
+    std::string text;
+    PlotData d;
+
+    double tree_ms = time_ms([&] { tree = o.model.value_tree(o.spot); }, 10);
+    double json_ms = time_ms(
+        [&] {
+          nlohmann::json data;
+          data["strike"] = o.strike;
+          data["v"] = tree;
+          text = data.dump();
+        },
+        10);
+
+    double build_ms = time_ms([&] { d = plot_data(o); }, 10);
+    double write_ms = time_ms([&] { write_plot_data(d, fn); }, 10);
+    size_t bytes = std::filesystem::file_size(fn);
+
+    std::cout << std::format("{:<8} {:>12} {:>12.4f} {:>12.4f} {:>12} {:>12.4f} {:>12.4f}\n", steps, text.size(), tree_ms, json_ms, bytes, build_ms,
+                             write_ms);
+    record({{"steps", steps}}, {{"json_bytes", text.size()},
+                                {"tree_time_ms", tree_ms},
+                                {"json_time_ms", json_ms},
+                                {"plot_bytes", bytes},
+                                {"plot_build_time_ms", build_ms},
+                                {"plot_write_time_ms", write_ms}});
+  }
+
+  std::filesystem::remove(fn);
+}
@@ -0,0 +1,6 @@
+# find_package(bopm) for an installed bopm_core, provides bopm::core
+include(CMakeFindDependencyMacro)
+find_dependency(nlohmann_json)
+find_dependency(Threads)
+
+include(${CMAKE_CURRENT_LIST_DIR}/bopmTargets.cmake)
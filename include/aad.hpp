@@ -0,0 +1,90 @@
+#ifndef AAD_HPP
+#define AAD_HPP
+
+#include "model.hpp"
+#include <cmath>
+#include <memory_resource>
+#include <vector>
+
+class Option;
+
+// reverse mode tape, each entry is an operation with up to two parents and the partial derivative of the
+// result with respect to each, storage comes from the memory resource given (an arena) so recording
+// never allocates per operation
+class Tape {
+public:
+  struct Entry {
+    int a, b;      // parent entries (-1 for constants)
+    double da, db; // partials with respect to each parent
+  };
+
+  std::pmr::vector<Entry> entries;
+  std::pmr::vector<double> adj; // adjoints, filled by reverse()
+
+  static thread_local Tape *active; // tape that AReal operations record onto
+
+  // makes a tape the active one, restoring the previous tape on destruction (including when recording throws)
+  class Recording {
+  public:
+    Recording(Tape &t);
+    ~Recording();
+
+    Recording(const Recording &) = delete;
+    Recording &operator=(const Recording &) = delete;
+
+  private:
+    Tape *prev;
+  };
+
+  Tape(std::pmr::memory_resource *mem);
+
+  int record(int a, double da, int b = -1, double db = 0); // returns the new entry, -1 if both parents are constants
+  int variable();                                           // new independent input
+
+  void reverse(); // propagates adjoints (seeded into adj) back to the inputs
+};
+
+// scalar recorded onto the active tape
+struct AReal {
+  double v;
+  int id;
+
+  AReal(double x = 0) : v(x), id(-1) {}
+  AReal(double x, int i) : v(x), id(i) {}
+};
+
+inline AReal operator+(AReal a, AReal b) { return AReal(a.v + b.v, Tape::active->record(a.id, 1, b.id, 1)); }
+inline AReal operator-(AReal a, AReal b) { return AReal(a.v - b.v, Tape::active->record(a.id, 1, b.id, -1)); }
+inline AReal operator*(AReal a, AReal b) { return AReal(a.v * b.v, Tape::active->record(a.id, b.v, b.id, a.v)); }
+inline AReal operator/(AReal a, AReal b) { return AReal(a.v / b.v, Tape::active->record(a.id, 1 / b.v, b.id, -a.v / (b.v * b.v))); }
+inline AReal operator-(AReal a) { return AReal(-a.v, Tape::active->record(a.id, -1)); }
+
+inline AReal &operator+=(AReal &a, AReal b) { return a = a + b; }
+inline AReal &operator*=(AReal &a, AReal b) { return a = a * b; }
+
+inline bool operator<(AReal a, AReal b) { return a.v < b.v; }
+inline bool operator>(AReal a, AReal b) { return a.v > b.v; }
+
+inline AReal exp(AReal a) {
+  double e = std::exp(a.v);
+  return AReal(e, Tape::active->record(a.id, e));
+}
+inline AReal log(AReal a) { return AReal(std::log(a.v), Tape::active->record(a.id, 1 / a.v)); }
+inline AReal sqrt(AReal a) {
+  double s = std::sqrt(a.v);
+  return AReal(s, Tape::active->record(a.id, 0.5 / s));
+}
+
+// first order sensitivities of the price to every model and option input
+struct Sensitivities {
+  float price;
+  float spot, strike, expiration, yield;
+  std::vector<float> rates, vols; // with respect to the rate and vol at each step
+};
+
+// prices the option on the binomial lattice (full, unpruned) and returns every sensitivity from one forward
+// and one reverse sweep, the lattice setup is recorded on a tape, the forward sweep is the lattice's own rollback
+// and its hand written adjoint reads back the node values and spots it kept (all held in a single arena)
+Sensitivities adjoint(const Option &o, const Model &m);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// bump allocator for pricing scratch memory (lattice buffers, node values, tapes)
+//
+// blocks are kept when the arena is rewound, so once it has grown to fit a pricing request, repeating that
+// request makes no heap allocations, deallocation is a no-op and memory is reclaimed by rewinding
+//
+// blocks of a huge page or more are mapped directly, 2mb aligned and backed by huge pages (see Pages) so
+// deep lattices and 2d slices don't thrash the tlb, and every page is touched as the block is mapped, so it
+// is placed on the numa node of the thread that owns the arena (first touch) rather than wherever the kernel
+// first happens to write it
+class Arena : public std::pmr::memory_resource {
+public:
+  enum class Pages {
+    Heap,        // operator new, whatever pages the allocator hands out
+    Transparent, // madvise(MADV_HUGEPAGE), honoured when transparent huge pages are "always" or "madvise"
+    Explicit,    // MAP_HUGETLB from the reserved pool (vm.nr_hugepages), falling back to transparent when empty
+                 // (both linux only, elsewhere blocks are plain 2mb aligned mappings)
+  };
+
+  static constexpr size_t huge_page = 2 << 20;
+
+  // position in the arena, rewinding to it releases everything allocated after it
+  struct Mark {
+    size_t block;
+    size_t offset;
+  };
+
+  // rewinds the arena to where it was on construction, so nested pricing calls can each own a scope
+  class Scope {
+  public:
+    Scope(Arena &a);
+    ~Scope();
+
+  private:
+    Arena &arena;
+    Mark mark;
+  };
+
+  Arena(size_t block_size = 1 << 20);
+  ~Arena();
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  Mark mark() const;
+  void rewind(Mark m); // O(1), blocks are kept for reuse
+  void reset();        // rewind to the start
+
+  size_t used() const;     // bytes handed out since the last reset
+  size_t capacity() const; // bytes held across all blocks
+
+  static Arena &local(); // the calling thread's arena
+
+  // page backing for blocks mapped from now on, by every arena in the process (transparent by default), blocks
+  // already held keep theirs
+  static void set_pages(Pages p);
+  static Pages pages();
+
+private:
+  struct Block {
+    std::byte *data;
+    size_t size;
+    bool mapped; // mmap rather than operator new
+  };
+
+  static Block map(size_t size);
+
+  std::vector<Block> blocks;
+  size_t block_size;
+  size_t current, offset; // block being allocated from, and offset into it
+
+  void *do_allocate(size_t bytes, size_t align) override;
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BLACKSCHOLES_HPP
+#define BLACKSCHOLES_HPP
+
+#include "options.hpp"
+
+double norm_cdf(double x); // standard normal distribution function
+
+// black-scholes price of a european option with continuous rate r, yield q and vol v over t years
+double black_scholes(Side side, double spot, double strike, double t, double r, double q, double v);
+
+// as above for an option under a flat model (used as the reference price and for control variates)
+double black_scholes(const Option &o, double r, double q, double v);
+
+// european price of the option under its own model, the limit the binomial lattice converges to: per step
+// rates and vols enter through their integrals, discrete dividends as the lattice handles them (cash escrowed
+// off spot, proportional scaling it)
+double black_scholes(const Option &o, const Model &m);
+
+#endif
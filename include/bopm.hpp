@@ -0,0 +1,32 @@
+#ifndef BOPM_HPP
+#define BOPM_HPP
+
+// public api of the bopm_core library, everything needed to build models and options, price them on any
+// engine and take sensitivities, with no ui or network dependencies
+//
+//   AmericanOption o;
+//   o.spot = 100, o.strike = 100, o.expiration = 1, o.side = Side::Put;
+//   o.model = Model(500, o.expiration, 0.05f, 0.2f);
+//   float price = o.price(Engine::Binomial);
+
+#include "aad.hpp"
+#include "arena.hpp"
+#include "blackscholes.hpp"
+#include "boundary.hpp"
+#include "cache.hpp"
+#include "fdm.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "lattice2d.hpp"
+#include "model.hpp"
+#include "options.hpp"
+#include "params.hpp"
+#include "planner.hpp"
+#include "plotdata.hpp"
+#include "pool.hpp"
+#include "rw.hpp"
+#include "service.hpp"
+#include "task.hpp"
+#include "trinomial.hpp"
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef BOUNDARY_HPP
+#define BOUNDARY_HPP
+
+#include "options.hpp"
+#include <stop_token>
+#include <vector>
+
+// early exercise boundary of an american option, the spot at which exercising becomes optimal at each step
+// of the model (puts are exercised at or below it, calls at or above it), interpolated between lattice nodes
+//
+// steps where the option is never exercised hold 0 for puts and infinity for calls
+struct Boundary {
+  Side side;
+  float strike;
+  std::vector<float> time; // years from now, one point per step plus expiration
+  std::vector<float> spot;
+  float vol; // rms vol of the model it was built from
+
+  float at(float t) const; // linear interpolation in time
+};
+
+// full rollback of the option's model, throws for non american options, and Cancelled once a stop is requested
+Boundary exercise_boundary(const Option &o, std::stop_token stop = {});
+
+// price from the early exercise premium integral (kim 1990), the european price plus the value of exercising
+// whenever spot crosses the boundary:
+//   put  = p(S) + int_0^T e^-R(t) (r(t) K N(-d2) - q S e^(R(t) - qt) N(-d1)) dt,   d1, d2 from S, B(t) and t
+//
+// the boundary is spot independent, and its log distance from the expiration value grows roughly in
+// proportion to vol, so a boundary from an earlier rollback (rescaled to the model's current vol) reprices
+// small spot and vol moves in microseconds, nodes sets the quadrature points, discrete dividends are not
+// supported (throws)
+float boundary_price(const Option &o, const Boundary &b, int nodes = 128);
+
+// reprices an american option against a cached boundary, rebuilding it by a full rollback only when spot or
+// vol have moved beyond the tolerances since it was built (the boundary itself doesn't depend on spot, but the
+// lattice it was read from is centred on the spot at the time)
+class BoundaryPricer {
+public:
+  BoundaryPricer(const Option &o, float spot_tol = 0.1, float vol_tol = 0.01); // relative spot move, absolute vol move
+
+  float price(float spot, float vol_shift = 0); // vol_shift is a parallel shift of the option model's vols
+
+  long rebuilds() const;
+  const Boundary &boundary() const;
+
+private:
+  AmericanOption option; // priced at the latest spot and vol shift
+  std::vector<float> vols;  // unshifted
+  Boundary cached;
+  float spot0, shift0, shift; // spot and vol shift the boundary was built at, and the current shift
+  float spot_tol, vol_tol;
+  long rebuilt;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "lattice.hpp"
+#include "model.hpp"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// least recently used cache of binomial lattices, so repricing the same model at a new spot or strike skips
+// setup entirely
+//
+// lattice geometry depends only on the model (steps, dt, rates, vols, yield, parameterisation, dividends and
+// pruning), spot and strike are only part of the key for the leisen-reimer lattice, which is centred on them
+//
+// safe to share between threads, lattices are handed out as shared pointers so an entry evicted while in use
+// stays alive until its last rollback finishes
+class LatticeCache {
+public:
+  LatticeCache(size_t capacity = 64 << 20); // bytes of lattice data held before evicting
+
+  LatticeCache(const LatticeCache &) = delete;
+  LatticeCache &operator=(const LatticeCache &) = delete;
+
+  template <typename T> std::shared_ptr<const BasicLattice<T>> get(const Model &m, float spot, float strike);
+
+  long hits() const;
+  long misses() const;
+  size_t size() const;  // entries held
+  size_t bytes() const; // lattice data held
+  void clear();         // drops every entry and zeroes the counters
+
+  static LatticeCache &global(); // shared by every pricing in the process
+
+  // get() on this thread builds a fresh lattice while one is alive, without looking it up, holding it or
+  // counting it, for lattices that are not the user's (the planner's convergence pricing)
+  class Bypass {
+  public:
+    Bypass();
+    ~Bypass();
+
+    Bypass(const Bypass &) = delete;
+    Bypass &operator=(const Bypass &) = delete;
+  };
+
+private:
+  // integers are kept out of the float words so step counts past 2^24 stay exact, floats are compared by their
+  // bits (with -0 taken as 0) so equality agrees with the hash, nans included
+  struct Key {
+    int scalar, steps;
+    std::vector<uint32_t> words;
+
+    bool operator==(const Key &) const = default;
+  };
+  using Value = std::variant<std::shared_ptr<const BasicLattice<float>>, std::shared_ptr<const BasicLattice<double>>>;
+
+  struct Hash {
+    size_t operator()(const Key &k) const; // fnv-1a over the key's integers and words
+  };
+
+  struct Entry {
+    Key key;
+    Value value;
+    size_t bytes;
+  };
+
+  mutable std::mutex lock;
+  std::list<Entry> order; // most recently used first
+  std::unordered_map<Key, std::list<Entry>::iterator, Hash> index;
+
+  size_t capacity, held;
+  std::atomic<long> hit_count, miss_count;
+
+  static void key(Key &k, const Model &m, float spot, float strike, int scalar);
+  void insert(const Key &k, Value v, size_t bytes);
+};
+
+#endif
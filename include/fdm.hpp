@@ -0,0 +1,37 @@
+#ifndef FDM_HPP
+#define FDM_HPP
+
+#include "model.hpp"
+#include <memory_resource>
+#include <vector>
+
+class Option;
+
+struct FdResult {
+  float price;
+  float delta, gamma, theta; // read straight off the grid at spot
+};
+
+// crank-nicolson finite difference grid in log spot, built from a Model (one time step per model step, using
+// that step's rate and vol), centred on spot so the price and greeks fall on grid nodes
+//
+// dividends are handled as in the lattice engines, the grid is over the dividend free process X and the
+// spot at node j of step i is X[j] * scale[i] + escrow[i]
+class FiniteDifference {
+public:
+  int steps, nodes;
+  float dt, dx;
+  float xmin; // log of the lowest grid node
+
+  std::pmr::vector<float> rates, vols; // rate and vol at each step
+  float yield;
+  std::pmr::vector<float> scale, escrow; // dividend adjustments at each step (size steps + 1)
+
+  FiniteDifference();
+  // n spatial nodes, defaults to one per step (min 101)
+  FiniteDifference(const Model &m, float spot, int n = 0, std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+};
+
+FdResult solve(const Option &o, const FiniteDifference &fd); // american options use a brennan-schwartz early exercise step
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include "nlohmann/json.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// hot path instrumentation, per phase call counts and wall time plus node and allocation counters
+//
+// each thread counts into its own counters, padded to their own cache lines so threads pricing in parallel
+// never contend on one, and only that thread writes them (relaxed loads and stores, no locked instructions),
+// reports sum them over every thread, including threads that have since exited
+//
+// on by default, build with -DBOPM_INSTRUMENT=0 and the macros below compile to nothing
+#ifndef BOPM_INSTRUMENT
+#define BOPM_INSTRUMENT 1
+#endif
+
+enum class Phase { Setup, Rollback, Greeks, Parse, Serialise, Fetch, Count };
+
+std::string phase_str(Phase p);
+
+namespace instrument {
+
+struct alignas(64) Counters {
+  std::atomic<long> calls[(int)Phase::Count];
+  std::atomic<long> ns[(int)Phase::Count];
+
+  std::atomic<long> nodes;       // lattice and grid nodes rolled back
+  std::atomic<long> allocations; // arena allocations
+  std::atomic<long> bytes;       // arena bytes handed out
+  std::atomic<long> blocks;      // arena blocks taken from the heap
+};
+
+Counters &counters(); // this thread's
+
+// counting on this thread is paused while one is alive, for work that is not the user's (the planner's
+// calibration rollbacks)
+class Pause {
+public:
+  Pause();
+  ~Pause();
+
+  Pause(const Pause &) = delete;
+  Pause &operator=(const Pause &) = delete;
+};
+
+// adds the time from construction to destruction to a phase
+class Timer {
+public:
+  Timer(Phase p) : phase(p), start(std::chrono::steady_clock::now()) {}
+  ~Timer();
+
+private:
+  Phase phase;
+  std::chrono::steady_clock::time_point start;
+};
+
+// counter must be one of this thread's
+inline void add(std::atomic<long> &counter, long n) { counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+void reset(); // counts from here on, the threads' counters are left as they are
+nlohmann::json to_json(); // headless dump
+std::string report();     // pricing report section
+
+} // namespace instrument
+
+#if BOPM_INSTRUMENT
+#define BOPM_CONCAT_(a, b) a##b
+#define BOPM_CONCAT(a, b) BOPM_CONCAT_(a, b)
+#define BOPM_TIME(phase) instrument::Timer BOPM_CONCAT(bopm_timer_, __LINE__)(phase)
+#define BOPM_COUNT(counter, n) instrument::add(instrument::counters().counter, n)
+#else
+#define BOPM_TIME(phase) ((void)0)
+#define BOPM_COUNT(counter, n) ((void)0)
+#endif
+
+#endif
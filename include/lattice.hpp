@@ -0,0 +1,143 @@
+#ifndef LATTICE_HPP
+#define LATTICE_HPP
+
+#include "model.hpp"
+#include "params.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+class Option;
+
+// recombining binomial lattice built from a Model, node j at step i (j up moves) has spot:
+//   (spot - escrow[0]) * centre[i] * sqrt(ratio)^(2j - i) + escrow[i]
+//
+// centre[i] is the factor of the middle of step i (d^i ratio^(i / 2)), neither it nor sqrt(ratio)^(2j - i) leaves
+// the range of T at a node unless that node's spot does (d^i and ratio^j alone overflow floats on deep, high vol
+// lattices)
+//
+// discrete dividends are handled without breaking recombination:
+//   cash dividends are escrowed, the lattice is built on spot less the present value of the dividends
+//   and the value still to be paid is added back onto each node (escrow)
+//   proportional dividends shift every node at or after the ex-date by (1 - amount) (centre)
+//
+// templated on the scalar the per step model data is held (and discounting is done) in, see Precision
+template <typename T> class BasicLattice {
+public:
+  int steps;
+  T dt;
+
+  T ratio; // uFac / dFac, constant across steps so nodes recombine
+
+  std::pmr::vector<T> uProb, disc;  // up probability and discount factor at each step (size steps)
+  std::pmr::vector<T> centre, escrow; // middle node factor and escrowed dividends at each step (size steps + 1)
+
+  float prune;                  // number of standard deviations kept either side of the forward (0 keeps every node)
+  std::pmr::vector<int> lo, hi; // band of nodes rolled back at each step (size steps + 1)
+
+  BasicLattice(std::pmr::memory_resource *mem = std::pmr::get_default_resource()); // empty, for setups built elsewhere (aad)
+
+  // uses the parameterisation selected in the model, buffers are allocated from mem (pricing passes the
+  // thread's Arena, longer lived lattices can stay on the heap)
+  BasicLattice(const Model &m, float spot, float strike, std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+  template <typename P> void build(const Model &m, float spot, float strike); // parameterisation chosen at compile time
+
+  long nodes() const;                                   // nodes rolled back, after pruning
+  float truncation_bound(float spot, float strike) const; // approximate bound on the price error from pruning
+};
+
+using Lattice = BasicLattice<double>; // the default precision, see Precision
+
+// backward induction over the lattice, returns price at the root
+template <typename T> T rollback(const Option &o, const BasicLattice<T> &l);
+
+// one step of a rollback, nodes are indexed by their up moves and valid over [lo, hi]
+template <typename T> struct Slice {
+  int step, lo, hi;
+  const T *spot;  // node spots
+  const T *value; // option values, after early exercise
+  const T *cont;  // continuation values (the discounted expectation over the next step), the payout at expiration
+};
+
+template <typename T> using SliceVisitor = std::function<void(const Slice<T> &)>;
+
+// as rollback, handing each step to visit once its values are final (expiration first, the root last), for
+// anything that needs more of the lattice than the price (plots, the exercise boundary, the adjoint's stored
+// values), visit may throw to stop the rollback, the caller times its own phase
+template <typename T> T rollback(const Option &o, const BasicLattice<T> &l, const std::type_identity_t<SliceVisitor<T>> &visit);
+
+// american price with the european as a control variate, both are rolled back together in one sweep over
+// the lattice (two value lanes) and the american corrected by the european lattice's error:
+//   american lattice - european lattice + european (closed form, black_scholes(o, m))
+// the last step is smoothed with black-scholes in both lanes so neither oscillates with the parity of the step
+// count, what is left of the two lattice errors is shared and the correction removes it (european options just
+// return the closed form)
+template <typename T> T rollback_cv(const Option &o, const BasicLattice<T> &l, double european);
+
+// discrete dividend adjustments at each of the model's steps (size steps + 1), shared by the lattice engines
+//   scale - product of (1 - amount) for proportional dividends gone ex at or before the step
+//   escrow - value at the step of cash dividends still to be paid before expiration
+void dividend_adjustments(const Model &m, std::pmr::vector<double> &scale, std::pmr::vector<double> &escrow);
+
+template <typename T> template <typename P> void BasicLattice<T>::build(const Model &m, float spot, float strike) {
+  steps = m.steps;
+  dt = m.dt;
+
+  // node spacing must be the same at every step for the tree to recombine, so factors come from the
+  // rms vol (preserving total variance) and mean rate, per step rates then go into the probabilities
+  T var = 0, rate = 0;
+  for (int i = 0; i < steps; i++) {
+    var += (T)m.vols[i] * m.vols[i];
+    rate += m.rates[i];
+  }
+
+  T u, d;
+  P::factors(rate / steps, (T)m.yield, std::sqrt(var / steps), dt, steps, (T)std::log(spot / strike), u, d);
+  ratio = u / d;
+
+  uProb.resize(steps);
+  disc.resize(steps);
+  for (int i = 0; i < steps; i++) {
+    uProb[i] = (std::exp(((T)m.rates[i] - m.yield) * dt) - d) / (u - d);
+    disc[i] = std::exp(-m.rates[i] * dt);
+  }
+
+  std::pmr::vector<double> scale(uProb.get_allocator()), esc(uProb.get_allocator());
+  dividend_adjustments(m, scale, esc);
+  escrow.assign(esc.begin(), esc.end());
+
+  // in double, d^i can underflow a float where sqrt(u d)^i is still in range
+  double mid = std::sqrt((double)u * d);
+  centre.resize(steps + 1);
+  for (int i = 0; i <= steps; i++) {
+    centre[i] = std::pow(mid, i) * scale[i];
+  }
+
+  // the number of up moves to step i is (close to) binomially distributed, keep nodes within prune standard
+  // deviations of its mean, bands move by at most one node a step so values outside are only read at the edges
+  prune = m.prune;
+  lo.resize(steps + 1);
+  hi.resize(steps + 1);
+
+  double mean = 0, spread = 0;
+  for (int i = 0; i <= steps; i++) {
+    lo[i] = 0;
+    hi[i] = i;
+
+    if (prune > 0) {
+      lo[i] = std::max(lo[i], (int)std::floor(mean - prune * std::sqrt(spread)));
+      hi[i] = std::min(hi[i], (int)std::ceil(mean + prune * std::sqrt(spread)));
+    }
+
+    if (i < steps) {
+      mean += uProb[i];
+      spread += uProb[i] * (1 - uProb[i]);
+    }
+  }
+}
+
+#endif
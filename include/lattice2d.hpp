@@ -0,0 +1,44 @@
+#ifndef LATTICE2D_HPP
+#define LATTICE2D_HPP
+
+#include <memory_resource>
+#include <vector>
+
+class RainbowOption;
+
+// recombining lattice over two correlated underlyings (boyle, evnine and gibbs 1989), both move up or down
+// every step so step i is an (i + 1) x (i + 1) slice, node (j, k) (j up moves of the first underlying, k of
+// the second) has spots:
+//   spot[0] * down[0]^i * ratio[0]^j,   spot[1] * down[1]^i * ratio[1]^k
+//
+// each underlying's factors come from its rms vol and its up probability from the per step rate and its
+// yield (as BasicLattice), so both marginals are exactly the crr binomial lattice, the four joint
+// probabilities then add the covariance between up moves that gives the correlation
+class Lattice2D {
+public:
+  int steps;
+  double dt;
+
+  double down[2], ratio[2]; // down factor and up / down of each underlying, constant across steps
+
+  std::pmr::vector<double> puu, pud, pdu, pdd, disc; // joint probabilities (pud: first up, second down) and discount factor at each step (size steps)
+
+  Lattice2D();
+
+  // throws std::invalid_argument if the models don't match (steps, expiration and the rate at every step, the
+  // underlyings share one rate and differ only in vol and yield), have discrete dividends, or the correlation
+  // is too close to +-1 for the step size (a joint probability would be negative)
+  Lattice2D(const RainbowOption &o, std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+
+  long nodes() const;
+};
+
+// backward induction over the lattice, returns price at the root
+//
+// each slice is split into this many bands of rows rolled back on the shared pool (0 uses one per worker),
+// every band of a step finishes before the next step starts and writes into a second slice so bands never
+// read a row another band has already overwritten, within a band rows are walked in column tiles so both
+// rows a node reads stay in l1 for the next row
+float rollback(const RainbowOption &o, const Lattice2D &l, int threads = 0);
+
+#endif
@@ -1,17 +1,30 @@
 #ifndef OPTIONS_HPP
 #define OPTIONS_HPP
 
+#include "model.hpp"
 #include "nlohmann/json.hpp"
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
 
 enum class Type { Undefined = -1, European = 0, American = 1, Asian = 2 };
 enum class Side { Undefined = -1, Call = 0, Put = 1 };
 enum class PayoffType { Undefined = -1, Fixed = 0, Floating = 1 };
+enum class Engine { Undefined = -1, Binomial = 0, Trinomial = 1, FiniteDifference = 2 };
+enum class RainbowPayoff { Undefined = -1, Spread = 0, Basket = 1, BestOf = 2, WorstOf = 3 };
 
 std::string type_str(Type t);
 std::string side_str(Side s);
 std::string payoff_type_str(PayoffType pt);
+std::string engine_str(Engine e);
+std::string rainbow_payoff_str(RainbowPayoff p);
+
+Type str_type(std::string s);
+Side str_side(std::string s);
+PayoffType str_payoff_type(std::string s);
+Engine str_engine(std::string s);
+RainbowPayoff str_rainbow_payoff(std::string s);
 
 class Option {
 public:
@@ -20,10 +33,22 @@ public:
   float expiration; // time until expiration (yrs)
   Type type;
   Side side;
+  Engine engine; // pricing engine, so step count can be traded for accuracy per option
+
+  Model model; // model used for pricing, must be attached (with expiration set) before calling price()
 
   Option(); // all members will be init'd as NaN or Undef, then filled in using interface
+  virtual ~Option() = default;
+
+  float payout(float spot) const; // returns payout of an option given a spot price
+
+  float price();                 // prices the option with its own engine
+  virtual float price(Engine e); // prices the option with the given engine, on a recombining lattice built from model
+
+  virtual nlohmann::json to_json(); // option parameters only, the model is saved separately
+  virtual void from_json(nlohmann::json j);
 
-  float payout(float spot); // returns payout of an option given a spot price
+  virtual std::unique_ptr<Option> clone() const; // copy keeping the derived type, for pricing off the calling thread
 
 protected:
   Option(Type t); // used by derived classes only
@@ -45,6 +70,47 @@ public:
   AsianOption(); // payoff type init'd as Undef
 
   float payout(std::vector<float> intervals); // payouts for asian options are dependent on asset price throughout the option lifetime
+
+  using Option::price;
+  float price(Engine e) override; // path dependent, so priced over every path of the model branches, dividends as the lattice applies them (engine is ignored)
+
+  nlohmann::json to_json() override; // adds the payoff type
+  void from_json(nlohmann::json j) override;
+
+  std::unique_ptr<Option> clone() const override;
+};
+
+// option on two correlated underlyings, european or american, paying out against the strike on:
+//   spread   - weight[0] * S1 - weight[1] * S2
+//   basket   - weight[0] * S1 + weight[1] * S2
+//   best of  - max(S1, S2)
+//   worst of - min(S1, S2)
+// priced on the two dimensional lattice (see Lattice2D)
+class RainbowOption {
+public:
+  std::array<std::string, 2> underlying; // optional
+  std::string currency;
+  std::array<float, 2> spot;
+  std::array<float, 2> weight; // spread and basket weights, both 1 by default
+  float strike;
+  float expiration; // time until expiration (yrs)
+  Type type;        // european or american
+  Side side;
+  RainbowPayoff payoff;
+  float correlation; // between the underlyings' returns
+
+  // one model per underlying, with the same steps and rates, each has its own vols and yield (discrete dividends
+  // are not supported)
+  std::array<Model, 2> model;
+
+  RainbowOption(); // all members will be init'd as NaN or Undef, then filled in using interface
+
+  float payout(float s1, float s2) const;
+
+  float price(int threads = 0); // rolled back in this many bands on the shared pool (0 uses one per worker)
+
+  nlohmann::json to_json(); // option parameters only, the models are saved separately
+  void from_json(nlohmann::json j);
 };
 
 #endif
\ No newline at end of file
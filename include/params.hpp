@@ -0,0 +1,82 @@
+#ifndef PARAMS_HPP
+#define PARAMS_HPP
+
+#include <cmath>
+#include <string>
+
+// lattice parameterisations, selects how up/down factors are derived from rate and volatility
+enum class Param { Undefined = -1, CRR = 0, JR = 1, Tian = 2, LR = 3 };
+
+std::string param_str(Param p);
+Param str_param(std::string s);
+
+/*
+parameterisation policies, used as template arguments so the lattice setup is specialised at compile time
+
+each computes the up and down factors of one step from (math functions are called unqualified so the
+policies also work with the adjoint scalar in aad.hpp):
+  r - risk free rate
+  q - dividend yield
+  v - volatility
+  dt - time between steps (yrs)
+  n - number of steps
+  m - moneyness, ln(spot / strike) (only used by LR)
+*/
+
+// Cox-Ross-Rubinstein, u = e^(v sqrt(dt)), d = 1 / u
+struct CRR {
+  template <typename T> static void factors(T, T, T v, T dt, int, T, T &u, T &d) {
+    using std::exp, std::sqrt;
+    u = exp(v * sqrt(dt));
+    d = 1 / u;
+  }
+};
+
+// Jarrow-Rudd, equal probabilities with the drift built into the factors
+struct JR {
+  template <typename T> static void factors(T r, T q, T v, T dt, int, T, T &u, T &d) {
+    using std::exp, std::sqrt;
+    T drift = (r - q - v * v / 2) * dt;
+    u = exp(drift + v * sqrt(dt));
+    d = exp(drift - v * sqrt(dt));
+  }
+};
+
+// Tian, matches the first three moments of the lognormal distribution
+struct Tian {
+  template <typename T> static void factors(T r, T q, T v, T dt, int, T, T &u, T &d) {
+    using std::exp, std::sqrt;
+    T M = exp((r - q) * dt);
+    T V = exp(v * v * dt);
+    T root = sqrt(V * V + 2 * V - 3);
+
+    u = M * V / 2 * (V + 1 + root);
+    d = M * V / 2 * (V + 1 - root);
+  }
+};
+
+// Leisen-Reimer, centres the lattice on the strike using the Peizer-Pratt inversion of the normal cdf,
+// converges at roughly second order (best with an odd number of steps)
+struct LR {
+  template <typename T> static T peizer_pratt(T z, int n) {
+    using std::exp, std::sqrt;
+    T a = z / (n + T(1) / 3 + T(0.1) / (n + 1));
+    T h = sqrt(T(0.25) - T(0.25) * exp(-a * a * (n + T(1) / 6)));
+    return z < 0 ? T(0.5) - h : T(0.5) + h;
+  }
+
+  template <typename T> static void factors(T r, T q, T v, T dt, int n, T m, T &u, T &d) {
+    using std::exp, std::sqrt;
+    T sd = v * sqrt(n * dt);
+    T d1 = (m + (r - q + v * v / 2) * n * dt) / sd;
+    T d2 = d1 - sd;
+
+    T p = peizer_pratt(d2, n);
+    T growth = exp((r - q) * dt);
+
+    u = growth * peizer_pratt(d1, n) / p;
+    d = (growth - p * u) / (1 - p);
+  }
+};
+
+#endif
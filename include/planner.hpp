@@ -0,0 +1,54 @@
+#ifndef PLANNER_HPP
+#define PLANNER_HPP
+
+#include "options.hpp"
+#include <stdexcept>
+#include <string>
+
+// thrown when no engine can price an option within the limits
+struct PlanError : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+// expected cost of pricing an option on one engine at a number of steps
+struct Estimate {
+  Engine engine; // Undefined for the asian path walk
+  bool walk;     // asian options walk all 2^steps paths over the model's branches, whatever their engine
+  int steps;
+  double nodes; // node updates (paths times steps for the asian walk, which can overflow any integer)
+  double bytes; // peak memory, including the model's branches for the asian walk
+  double ms;    // from the throughput measured by calibration()
+  double error; // expected absolute price error, nan where it isn't modelled (asian options)
+};
+
+std::string estimate_str(const Estimate &e);
+
+// resources pricing may use, memory defaults to half of physical memory
+struct Limits {
+  double bytes = default_bytes();
+  double ms = 60000;
+
+  static double default_bytes();
+};
+
+// throughput of each engine on this machine (ns per node update), measured once per process by timing a
+// rollback of each on a fixed option, the first call takes a few tens of ms
+struct Calibration {
+  double binomial_float, binomial_double, trinomial, fdm, asian;
+};
+
+const Calibration &calibration();
+
+// cost of pricing the option (model attached, as for Option::price()) on engine e at the given steps, error is
+// extrapolated from the option's own prices at 128, 256 and 512 steps (so costs a few ms)
+Estimate estimate(const Option &o, Engine e, int steps);
+
+// the engine and steps pricing the option to within accuracy (absolute) in the least expected time, throws
+// PlanError if none gets there within the limits, asian options are only checked at their model's steps
+Estimate plan(const Option &o, double accuracy, const Limits &limits = {});
+
+// throws PlanError if pricing the option as it stands (its own engine and model steps) would exceed the
+// limits, or a float lattice's spots would overflow, called before building anything proportional to the steps
+void check(const Option &o, const Limits &limits = {});
+
+#endif
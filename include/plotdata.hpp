@@ -0,0 +1,39 @@
+#ifndef PLOTDATA_HPP
+#define PLOTDATA_HPP
+
+#include "nlohmann/json.hpp"
+#include "options.hpp"
+#include <stop_token>
+#include <string>
+#include <vector>
+
+// node spots, option values, deltas and thetas over the binomial lattice, built in one backward pass after
+// pricing and shared by every plot
+//
+// the lattice is downsampled to at most budget nodes, keeping about sqrt(budget) evenly spaced steps and at
+// most that many evenly spaced nodes on each, so large lattices plot as quickly as small ones
+struct PlotData {
+  int steps;    // steps in the full lattice
+  float strike;
+
+  std::vector<int> rows;   // lattice step of each kept row
+  std::vector<int> offset; // start of each kept row in the node arrays (size rows + 1)
+
+  std::vector<int> node;                        // index of each kept node within its step
+  std::vector<float> spot, value, delta, theta; // at each kept node, nan where undefined (delta at expiration, theta on the last
+                                                // two steps and beyond the spots two steps on)
+};
+
+constexpr size_t plot_budget = 4096; // default node budget
+
+// asian options only get node spots (values are path dependent), throws Cancelled once a stop is requested
+PlotData plot_data(const Option &o, size_t budget = plot_budget, std::stop_token stop = {});
+
+// one of the per node arrays split into its kept rows, earliest first, rows undefined at every node are left out
+std::vector<std::vector<float>> plot_rows(const PlotData &d, const std::vector<float> &field);
+
+// writes the arrays back to back as raw little endian int32 / float32 to fn, returns the metadata the shaders
+// need to read them (numpy.fromfile with each array's dtype and count, in order)
+nlohmann::json write_plot_data(const PlotData &d, const std::string &fn);
+
+#endif
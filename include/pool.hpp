@@ -0,0 +1,59 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include "options.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// cpus of each numa node, read from sysfs (a single node holding every cpu where that isn't available)
+std::vector<std::vector<int>> numa_nodes();
+
+// fixed set of worker threads for batch pricing, each pinned to its own cpu with workers spread round robin
+// across numa nodes, pricing scratch comes from the worker's own (thread local) arena, so it is first touched
+// on, and stays on, the worker's node
+class ThreadPool {
+public:
+  ThreadPool(int threads = 0, bool pin = true); // 0 uses every cpu
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const;
+  int pinned() const; // workers pinned to their cpu so far, any others run wherever the scheduler puts them
+
+  // runs f(i) for every i in [0, n) on the workers, handing out chunks of indices as workers free up, blocks
+  // until all have run and rethrows the first exception thrown
+  //
+  // callers on different threads take turns, and calls from a worker of any pool (f calling parallel_for)
+  // run inline on that worker, rather than waiting on workers that are busy running the outer call
+  void parallel_for(size_t n, const std::function<void(size_t)> &f);
+
+  static ThreadPool &global(); // pinned, one worker per cpu
+
+private:
+  std::vector<std::thread> workers;
+  std::atomic<int> pinned_workers{0};
+
+  std::mutex submit; // held by the caller whose job is running
+  std::mutex m;
+  std::condition_variable wake, finished;
+  const std::function<void(size_t)> *job = nullptr;
+  size_t total = 0, next = 0, chunk = 1, running = 0;
+  long generation = 0;
+  bool stopping = false;
+  std::exception_ptr error;
+
+  void work(int cpu);
+};
+
+// prices every option with its own engine across the pool, prices are in the options' order
+std::vector<float> price_batch(const std::vector<Option *> &options, ThreadPool &pool = ThreadPool::global());
+
+#endif
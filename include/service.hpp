@@ -0,0 +1,101 @@
+#ifndef SERVICE_HPP
+#define SERVICE_HPP
+
+#include "nlohmann/json.hpp"
+#include "options.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// bounded queue of requests between the reader and the pricer, spot ticks for an underlying that already has
+// a tick waiting are merged into it (only the latest spot matters), so a burst of ticks can't grow the queue
+class TickQueue {
+public:
+  struct Item {
+    nlohmann::json message; // any request other than a tick
+    std::string underlying; // set for ticks
+    float spot;
+    Clock::time_point arrived; // of the oldest tick merged into this one
+  };
+
+  TickQueue(size_t capacity);
+
+  void push(Item item); // blocks while the queue is full
+  Item pop();           // blocks while the queue is empty
+
+  long coalesced() const; // ticks merged into one already waiting
+
+private:
+  mutable std::mutex lock;
+  std::condition_variable not_full, not_empty;
+
+  std::list<Item> items;
+  std::unordered_map<std::string, std::list<Item>::iterator> pending; // waiting ticks by underlying
+
+  size_t capacity;
+  long merged;
+};
+
+// tick to price latencies, the most recent samples are kept for percentiles
+class LatencyStats {
+public:
+  LatencyStats(size_t window = 1 << 16);
+
+  void record(Clock::duration d);
+  double percentile(double p) const; // microseconds, over the window
+  long count() const;
+
+private:
+  std::vector<float> samples;
+  long n;
+};
+
+// long running pricing mode, reads json requests one per line and writes json responses one per line
+//
+// requests:
+//   {"op": "option", "id": ..., "option": {...}, "model": {...}} - adds or replaces an option and prices it
+//   {"op": "remove", "id": ...}
+//   {"op": "tick", "underlying": ..., "spot": ...}                - reprices the options on that underlying
+//   {"op": "stats"}                                              - latency percentiles and cache counters
+//   {"op": "quit"}
+//
+// options and their models are held between requests, binomial lattices are shared through the lattice cache
+// so a tick only rolls back
+class PricingService {
+public:
+  PricingService(std::ostream &out, size_t capacity = 1024);
+
+  void run(std::istream &in); // until end of input or a quit request, reading and pricing run on separate threads
+
+  nlohmann::json stats() const; // called from the pricer
+
+private:
+  std::ostream &out;
+  std::mutex write_lock; // errors from the reader and prices from the pricer share out
+
+  TickQueue queue;
+  LatencyStats latency;
+
+  std::unordered_map<std::string, std::unique_ptr<Option>> options;
+  std::unordered_map<std::string, std::vector<std::string>> by_underlying; // option ids on each underlying
+  long ticks;
+
+  void read(std::istream &in);
+  bool handle(const TickQueue::Item &item); // returns false on quit
+  void add(const std::string &id, const nlohmann::json &request);
+  void remove(const std::string &id);
+  void reprice(const TickQueue::Item &tick);
+  void emit(const nlohmann::json &response);
+};
+
+int serve(std::istream &in, std::ostream &out); // runs a PricingService, used by bopm_serve
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include "options.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// thrown out of an engine's rollback once a stop has been requested for the task it runs in
+struct Cancelled : std::runtime_error {
+  Cancelled() : std::runtime_error("pricing cancelled") {}
+};
+
+// progress of the pricing task running on this thread, engines call Progress::step() once per time step
+// rolled back (or step(n) for n at once), which counts it and throws Cancelled if a stop has been requested (a
+// single thread local load on threads with no task)
+class Progress {
+public:
+  std::atomic<long> done{0}, total{0}; // steps rolled back, and to roll back over the whole task
+  std::stop_token stop;
+
+  static Progress *&local(); // this thread's progress, null outside a task
+
+  static void step(long n = 1) {
+    if (Progress *p = local()) {
+      p->done.fetch_add(n, std::memory_order_relaxed);
+      if (p->stop.stop_requested()) {
+        throw Cancelled();
+      }
+    }
+  }
+};
+
+// prices a copy of an option on its own thread so the caller stays responsive, first on coarser models (by
+// default a quarter and a half of the model's steps) so a usable price is available almost immediately, then
+// on the full model, each refinement's price is published as soon as its rollback finishes
+class PricingTask {
+public:
+  struct Result {
+    int steps;
+    float price;
+    double ms; // wall time of this refinement
+  };
+
+  // the option's model must be attached as for Option::price(), steps are the refinements in order (empty uses
+  // steps / 4, steps / 2 and steps)
+  PricingTask(const Option &o, std::vector<int> steps = {});
+  ~PricingTask(); // requests a stop and waits for the thread
+
+  void cancel(); // the running rollback throws Cancelled at its next step, finished results are kept
+
+  bool done() const;                   // every refinement finished, or pricing failed or was cancelled
+  float progress() const;              // fraction of all refinements' steps rolled back
+  std::vector<Result> results() const; // finished refinements, coarsest first
+
+  // waits for the task and returns the finest finished result, rethrows anything pricing threw other than a
+  // cancellation (Cancelled if it was cancelled before any refinement finished)
+  Result wait();
+
+private:
+  std::unique_ptr<Option> option;
+  std::vector<int> steps;
+  Progress prog;
+
+  mutable std::mutex m;
+  std::vector<Result> finished;
+  std::exception_ptr error;
+  std::atomic<bool> over{false};
+
+  std::jthread worker; // last, so it starts after (and is joined before) everything it uses
+
+  void run(std::stop_token stop);
+};
+
+#endif
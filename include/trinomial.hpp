@@ -0,0 +1,32 @@
+#ifndef TRINOMIAL_HPP
+#define TRINOMIAL_HPP
+
+#include "model.hpp"
+#include <memory_resource>
+#include <vector>
+
+class Option;
+
+// recombining trinomial lattice built from a Model, step i has 2i + 1 nodes, node j (0 at the bottom) has spot:
+//   (spot - escrow[0]) * scale[i] * e^((j - i) * dx) + escrow[i]
+//
+// node spacing is fixed by the largest vol in the model, per step vols and rates are then matched exactly by
+// the branch probabilities (unlike the binomial lattice, which has to fold per step vols into one rms vol)
+class Trinomial {
+public:
+  int steps;
+  float dt;
+  float dx; // log spacing between nodes
+
+  std::pmr::vector<float> uProb, mProb, dProb, disc; // branch probabilities and discount factor at each step (size steps)
+  std::pmr::vector<float> scale, escrow;             // dividend adjustments at each step (size steps + 1)
+
+  std::pmr::vector<float> grid; // e^(k * dx) for k in [-steps, steps], shared by every step
+
+  Trinomial();
+  Trinomial(const Model &m, std::pmr::memory_resource *mem = std::pmr::get_default_resource());
+};
+
+float rollback(const Option &o, const Trinomial &t); // simd backward induction over the lattice, returns price at the root
+
+#endif
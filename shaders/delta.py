@@ -1,24 +1,32 @@
-
 import matplotlib.pyplot as plt
+import numpy as np
 
-fig, ax = plt.subplots()
+# arrays written by write_plot_data (plotdata.hpp), read back to back in the order listed
+a = {}
+with open(file, 'rb') as f:
+    for name, dtype, count in arrays:
+        a[name] = np.fromfile(f, dtype=dtype, count=count)
+
+x = np.repeat(a['rows'], np.diff(a['offset']))
+y = a['spot']
+labels = a['delta']
 
-x = []
-y = []
-labels = []
-for i in range(len(delta_tree)):
-    for ii in range(len(delta_tree[i])):
-        x.append(i+1)
-        y.append(value_tree[i][ii])
-        labels.append(delta_tree[i][ii])
+# nodes where delta is undefined (nan) are left out
+keep = ~np.isnan(labels)
+x, y, labels = x[keep], y[keep], labels[keep]
+
+fig, ax = plt.subplots()
 
-scatter = ax.scatter(x, y, c=labels, cmap='coolwarm', s=300, edgecolors='black')
-plt.colorbar(scatter, label='Label Value')
+# marker size shrinks as the node count grows, values are only printed while they stay legible
+size = max(4, 300 * min(1, 200 / max(len(x), 1)))
+scatter = ax.scatter(x, y, c=labels, cmap='coolwarm', s=size, edgecolors='black' if len(x) <= 200 else 'none')
+plt.colorbar(scatter, label='Delta')
 
-for i in range(len(x)):
-    ax.text(x[i], y[i], f'{labels[i]:.2f}', color='black', ha='center', va='center', fontsize=8)
+if len(x) <= 200:
+    for i in range(len(x)):
+        ax.text(x[i], y[i], f'{labels[i]:.2f}', color='black', ha='center', va='center', fontsize=8)
 
 ax.set_xlabel('Steps')
 ax.set_ylabel('Asset Value')
 ax.set_title('Binomial Model - Delta Plot')
-plt.show()
\ No newline at end of file
+plt.show()
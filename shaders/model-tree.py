@@ -1,18 +1,40 @@
 import matplotlib.pyplot as plt
+import numpy as np
+from matplotlib.collections import LineCollection
+
+# arrays written by write_plot_data (plotdata.hpp), read back to back in the order listed
+a = {}
+with open(file, 'rb') as f:
+    for name, dtype, count in arrays:
+        a[name] = np.fromfile(f, dtype=dtype, count=count)
+
+rows, offset, node, spot = a['rows'], a['offset'], a['node'], a['spot']
+x = np.repeat(rows, np.diff(offset))
 
 fig, ax = plt.subplots()
-for i in range(len(v)-1):
-    tmp=[x for x in v[i] for _ in (0, 1)]
-    for ii in range(len(tmp)):
-        ax.plot([i,i+1], [tmp[ii], v[i+1][ii]], color='black', label='Price Path')
-        ax.axhline(v[i+1][ii], color='grey', linestyle='dotted', linewidth=0.5, label='Outcomes')
+
+if len(rows) == steps + 1 and len(node) == (steps + 1) * (steps + 2) // 2:
+    # every node kept, recombining tree, node ii moves down to ii and up to ii+1
+    segments = []
+    for i in range(steps):
+        s, t = spot[offset[i]:offset[i + 1]], spot[offset[i + 1]:offset[i + 2]]
+        segments += [[(i, s[ii]), (i + 1, t[ii])] for ii in range(len(s))]
+        segments += [[(i, s[ii]), (i + 1, t[ii + 1])] for ii in range(len(s))]
+    ax.add_collection(LineCollection(segments, colors='black', linewidths=0.5, label='Price Path'))
+else:
+    # downsampled, edges no longer join kept nodes so only the nodes are drawn
+    ax.scatter(x, spot, s=2, color='black', label='Nodes')
+
+last = spot[offset[-2]:offset[-1]]
+ax.hlines(last, 0, steps, color='grey', linestyle='dotted', linewidth=0.5, label='Outcomes')
 
 ax.axhline(strike, color='red', linestyle='dashed', linewidth=0.8, label='Strike')
 ax.set_title('Binomial Model')
 ax.set_xlabel('Steps')
 ax.set_ylabel('Asset Price')
+ax.autoscale()
 
 handles, labels = plt.gca().get_legend_handles_labels()
 lgnd = dict(zip(labels, handles))
 ax.legend(lgnd.values(), lgnd.keys())
-plt.show()
\ No newline at end of file
+plt.show()
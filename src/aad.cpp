@@ -0,0 +1,266 @@
+#include "aad.hpp"
+#include "arena.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "options.hpp"
+#include "params.hpp"
+#include <algorithm>
+
+thread_local Tape *Tape::active = nullptr;
+
+Tape::Tape(std::pmr::memory_resource *mem) : entries(mem), adj(mem) {}
+
+Tape::Recording::Recording(Tape &t) : prev(active) { active = &t; }
+
+Tape::Recording::~Recording() { active = prev; }
+
+int Tape::record(int a, double da, int b, double db) {
+  if (a < 0 && b < 0) {
+    return -1;
+  }
+
+  entries.push_back({a, b, da, db});
+  return entries.size() - 1;
+}
+
+int Tape::variable() {
+  entries.push_back({-1, -1, 0, 0});
+  return entries.size() - 1;
+}
+
+void Tape::reverse() {
+  adj.resize(entries.size(), 0);
+
+  for (int k = entries.size() - 1; k >= 0; k--) {
+    const Entry &e = entries[k];
+    if (e.a >= 0) {
+      adj[e.a] += adj[k] * e.da;
+    }
+    if (e.b >= 0) {
+      adj[e.b] += adj[k] * e.db;
+    }
+  }
+}
+
+namespace {
+
+// lattice setup mirroring Lattice::build, on adjoint scalars
+struct Setup {
+  AReal s0, ratio;
+  std::pmr::vector<AReal> uProb, disc, base, escrow;
+
+  Setup(std::pmr::memory_resource *mem) : uProb(mem), disc(mem), base(mem), escrow(mem) {}
+};
+
+template <typename P>
+void setup(Setup &st, const Model &m, int n, AReal spot, AReal strike, AReal T, AReal q, const std::pmr::vector<AReal> &r,
+           const std::pmr::vector<AReal> &v) {
+  AReal dt = T / n;
+
+  AReal var = 0, rate = 0;
+  for (int i = 0; i < n; i++) {
+    var += v[i] * v[i];
+    rate += r[i];
+  }
+
+  AReal u, d;
+  P::factors(rate / n, q, sqrt(var / n), dt, n, log(spot / strike), u, d);
+  st.ratio = u / d;
+
+  for (int i = 0; i < n; i++) {
+    st.uProb[i] = (exp((r[i] - q) * dt) - d) / (u - d);
+    st.disc[i] = exp(-r[i] * dt);
+  }
+
+  // dividend adjustments, as in dividend_adjustments()
+  std::pmr::vector<AReal> growth(n + 1, AReal(0), st.uProb.get_allocator());
+  for (int i = 0; i < n; i++) {
+    growth[i + 1] = growth[i] + r[i] * dt;
+  }
+
+  AReal dpow = 1;
+  for (int i = 0; i <= n; i++) {
+    AReal scale = 1, escrow = 0;
+    double t = i * dt.v;
+
+    for (const Dividend &div : m.dividends) {
+      if (div.time <= 0 || div.time > n * dt.v) {
+        continue;
+      }
+
+      if (div.type == DividendType::Proportional && div.time <= t) {
+        scale *= 1 - div.amount;
+      } else if (div.type == DividendType::Cash && div.time > t) {
+        int k = std::min((int)(div.time / dt.v), n - 1);
+        escrow += div.amount * exp(growth[i] - (growth[k] + r[k] * (div.time - k * dt)));
+      }
+    }
+
+    st.base[i] = dpow * scale;
+    st.escrow[i] = escrow;
+    dpow *= d;
+  }
+
+  st.s0 = spot - st.escrow[0];
+}
+
+} // namespace
+
+Sensitivities adjoint(const Option &o, const Model &m) {
+  BOPM_TIME(Phase::Greeks);
+  int n = m.steps;
+
+  // the thread's arena holds the tape, setup and node values, its blocks are kept between calls so repeated
+  // sensitivities reuse the same memory
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  Tape tape(&arena);
+  tape.entries.reserve(32 * (n + 1) * (m.dividends.size() + 1));
+  Tape::Recording recording(tape);
+
+  // inputs
+  AReal spot(o.spot, tape.variable()), strike(o.strike, tape.variable());
+  AReal T(m.dt * n, tape.variable()), q(m.yield, tape.variable());
+  std::pmr::vector<AReal> r(n, &arena), v(n, &arena);
+  for (int i = 0; i < n; i++) {
+    r[i] = AReal(m.rates[i], tape.variable());
+    v[i] = AReal(m.vols[i], tape.variable());
+  }
+
+  Setup st(&arena);
+  st.uProb.resize(n);
+  st.disc.resize(n);
+  st.base.resize(n + 1);
+  st.escrow.resize(n + 1);
+
+  if (m.param == Param::JR) {
+    setup<JR>(st, m, n, spot, strike, T, q, r, v);
+  } else if (m.param == Param::Tian) {
+    setup<Tian>(st, m, n, spot, strike, T, q, r, v);
+  } else if (m.param == Param::LR) {
+    setup<LR>(st, m, n, spot, strike, T, q, r, v);
+  } else /* CRR */ {
+    setup<CRR>(st, m, n, spot, strike, T, q, r, v);
+  }
+
+  bool american = o.type == Type::American;
+  double sign = o.side == Side::Call ? 1 : -1, k = o.strike;
+  double s0 = st.s0.v, ratio = st.ratio.v;
+
+  // the recorded setup as a lattice, rolled back by the lattice's own kernel
+  BasicLattice<double> l(&arena);
+  l.steps = n;
+  l.dt = m.dt;
+  l.ratio = ratio;
+  l.uProb.resize(n);
+  l.disc.resize(n);
+  l.centre.resize(n + 1);
+  l.escrow.resize(n + 1);
+  l.lo.assign(n + 1, 0);
+  l.hi.resize(n + 1);
+  for (int i = 0; i <= n; i++) {
+    if (i < n) {
+      l.uProb[i] = st.uProb[i].v;
+      l.disc[i] = st.disc[i].v;
+    }
+    l.centre[i] = st.base[i].v * std::pow(std::sqrt(ratio), i);
+    l.escrow[i] = st.escrow[i].v;
+    l.hi[i] = i;
+  }
+
+  // forward sweep (backward induction), keeping every node value and dividend free node spot
+  // (s0 base[i] ratio^j), row i starts at i(i + 1) / 2
+  std::pmr::vector<double> val((n + 1) * (n + 2) / 2, &arena), xs(val.size(), &arena);
+  auto row = [&](int i) { return val.data() + i * (i + 1) / 2; };
+  auto xrow = [&](int i) { return xs.data() + i * (i + 1) / 2; };
+
+  rollback<double>(o, l, [&](const Slice<double> &sl) {
+    double *vi = row(sl.step), *xi = xrow(sl.step);
+    for (int j = 0; j <= sl.step; j++) {
+      vi[j] = sl.value[j];
+      xi[j] = sl.spot[j] - l.escrow[sl.step];
+    }
+  });
+
+  // reverse sweep from the root, accumulating adjoints of the setup outputs
+  double s0_bar = 0, ratio_bar = 0, strike_bar = 0;
+  std::pmr::vector<double> p_bar(n, 0, &arena), df_bar(n, 0, &arena), base_bar(n + 1, 0, &arena), escrow_bar(n + 1, 0, &arena);
+  std::pmr::vector<double> cur(n + 1, 0, &arena), nxt(n + 1, 0, &arena);
+
+  // adjoint of the payout max(sign * (x + escrow[i] - k), 0) at node j of step i, x = s0 base[i] ratio^j
+  auto payout_bar = [&](int i, int j, double x, double g) {
+    s0_bar += g * x / s0;
+    base_bar[i] += g * x / st.base[i].v;
+    ratio_bar += g * j * x / ratio;
+    escrow_bar[i] += g;
+    strike_bar -= g;
+  };
+
+  cur[0] = 1;
+  for (int i = 0; i < n; i++) {
+    double *vx = row(i + 1), *xi = xrow(i), p = st.uProb[i].v, df = st.disc[i].v;
+    std::fill(nxt.begin(), nxt.begin() + i + 2, 0);
+
+    for (int j = 0; j <= i; j++) {
+      double vb = cur[j];
+      if (vb == 0) {
+        continue;
+      }
+
+      double ev = p * vx[j + 1] + (1 - p) * vx[j];
+      double ex = sign * (xi[j] + st.escrow[i].v - k);
+
+      if (american && ex > df * ev) {
+        payout_bar(i, j, xi[j], sign * vb);
+      } else {
+        df_bar[i] += vb * ev;
+        p_bar[i] += vb * df * (vx[j + 1] - vx[j]);
+        nxt[j + 1] += vb * df * p;
+        nxt[j] += vb * df * (1 - p);
+      }
+    }
+    std::swap(cur, nxt);
+  }
+
+  double *xn = xrow(n);
+  for (int j = 0; j <= n; j++) {
+    if (cur[j] != 0 && sign * (xn[j] + st.escrow[n].v - k) > 0) {
+      payout_bar(n, j, xn[j], sign * cur[j]);
+    }
+  }
+
+  // seed the setup outputs and propagate back through the tape to the inputs
+  tape.adj.assign(tape.entries.size(), 0);
+  auto seed = [&](AReal x, double bar) {
+    if (x.id >= 0) {
+      tape.adj[x.id] += bar;
+    }
+  };
+  seed(st.s0, s0_bar);
+  seed(st.ratio, ratio_bar);
+  for (int i = 0; i < n; i++) {
+    seed(st.uProb[i], p_bar[i]);
+    seed(st.disc[i], df_bar[i]);
+  }
+  for (int i = 0; i <= n; i++) {
+    seed(st.base[i], base_bar[i]);
+    seed(st.escrow[i], escrow_bar[i]);
+  }
+  tape.reverse();
+
+  Sensitivities res;
+  res.price = row(0)[0];
+  res.spot = tape.adj[spot.id];
+  res.strike = tape.adj[strike.id] + strike_bar;
+  res.expiration = tape.adj[T.id];
+  res.yield = tape.adj[q.id];
+  res.rates.resize(n);
+  res.vols.resize(n);
+  for (int i = 0; i < n; i++) {
+    res.rates[i] = tape.adj[r[i].id];
+    res.vols[i] = tape.adj[v[i].id];
+  }
+
+  return res;
+}
@@ -0,0 +1,134 @@
+#include "arena.hpp"
+#include "instrument.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+
+namespace {
+
+std::atomic<Arena::Pages> page_policy{Arena::Pages::Transparent};
+
+} // namespace
+
+Arena::Scope::Scope(Arena &a) : arena(a), mark(a.mark()) {}
+
+Arena::Scope::~Scope() { arena.rewind(mark); }
+
+Arena::Arena(size_t bs) : block_size(bs), current(0), offset(0) {}
+
+Arena::~Arena() {
+  for (Block &b : blocks) {
+    if (b.mapped) {
+      munmap(b.data, b.size);
+    } else {
+      ::operator delete(b.data, std::align_val_t(alignof(std::max_align_t)));
+    }
+  }
+}
+
+Arena::Mark Arena::mark() const { return {current, offset}; }
+
+void Arena::rewind(Mark m) {
+  current = m.block;
+  offset = m.offset;
+}
+
+void Arena::reset() { rewind({0, 0}); }
+
+size_t Arena::used() const {
+  size_t n = offset;
+  for (size_t i = 0; i < current && i < blocks.size(); i++) {
+    n += blocks[i].size;
+  }
+  return n;
+}
+
+size_t Arena::capacity() const {
+  size_t n = 0;
+  for (const Block &b : blocks) {
+    n += b.size;
+  }
+  return n;
+}
+
+Arena &Arena::local() {
+  thread_local Arena arena;
+  return arena;
+}
+
+void Arena::set_pages(Pages p) { page_policy = p; }
+
+Arena::Pages Arena::pages() { return page_policy; }
+
+Arena::Block Arena::map(size_t size) {
+  Pages p = page_policy;
+  size = (size + huge_page - 1) & ~(huge_page - 1);
+
+  if (p == Pages::Heap || size < huge_page) {
+    return {(std::byte *)::operator new(size, std::align_val_t(alignof(std::max_align_t))), size, false};
+  }
+
+#if defined(__linux__)
+  if (p == Pages::Explicit) {
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+    if (data != MAP_FAILED) {
+      return {(std::byte *)data, size, true};
+    }
+  }
+#endif
+
+  // over map by a huge page and trim either end, so the block starts on a huge page boundary
+  std::byte *raw = (std::byte *)mmap(nullptr, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+
+  std::byte *data = (std::byte *)(((uintptr_t)raw + huge_page - 1) & ~(uintptr_t)(huge_page - 1));
+  if (data > raw) {
+    munmap(raw, data - raw);
+  }
+  munmap(data + size, raw + huge_page - data);
+
+#if defined(__linux__)
+  madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+  // fault every page in now, from the thread that owns the arena
+  for (size_t i = 0; i < size; i += 4096) {
+    ((volatile std::byte *)data)[i] = std::byte(0);
+  }
+
+  return {data, size, true};
+}
+
+void *Arena::do_allocate(size_t bytes, size_t align) {
+  // move through the kept blocks until one has room, only going to the heap when past the last of them
+  while (current < blocks.size()) {
+    // aligned on the address, heap blocks are only aligned to max_align_t
+    Block &b = blocks[current];
+    uintptr_t base = (uintptr_t)b.data;
+    size_t start = ((base + offset + align - 1) & ~(uintptr_t)(align - 1)) - base;
+
+    if (start + bytes <= b.size) {
+      offset = start + bytes;
+      BOPM_COUNT(allocations, 1);
+      BOPM_COUNT(bytes, bytes);
+      return b.data + start;
+    }
+
+    current++;
+    offset = 0;
+  }
+
+  // new block, big enough for the request at any alignment of its start and doubling so deep lattices settle
+  // into a few blocks
+  size_t size = std::max(bytes + align, blocks.empty() ? block_size : blocks.back().size * 2);
+  blocks.push_back(size >= huge_page ? map(size) : Block{(std::byte *)::operator new(size, std::align_val_t(alignof(std::max_align_t))), size, false});
+  BOPM_COUNT(blocks, 1);
+
+  current = blocks.size() - 1;
+  offset = 0;
+  return do_allocate(bytes, align);
+}
@@ -0,0 +1,48 @@
+#include "blackscholes.hpp"
+#include "arena.hpp"
+#include "lattice.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+double norm_cdf(double x) { return 0.5 * std::erfc(-x / std::numbers::sqrt2); }
+
+double black_scholes(Side side, double spot, double strike, double t, double r, double q, double v) {
+  double fwd = spot * std::exp(-q * t), pv = strike * std::exp(-r * t);
+
+  // at expiration (or with no vol) the option is worth its discounted intrinsic value
+  double sd = v * std::sqrt(t);
+  if (sd <= 0) {
+    return side == Side::Call ? std::max(fwd - pv, 0.0) : std::max(pv - fwd, 0.0);
+  }
+
+  double d1 = (std::log(spot / strike) + (r - q + v * v / 2) * t) / sd;
+  double d2 = d1 - sd;
+
+  if (side == Side::Call) {
+    return fwd * norm_cdf(d1) - pv * norm_cdf(d2);
+  } else /* Put */ {
+    return pv * norm_cdf(-d2) - fwd * norm_cdf(-d1);
+  }
+}
+
+double black_scholes(const Option &o, double r, double q, double v) { return black_scholes(o.side, o.spot, o.strike, o.expiration, r, q, v); }
+
+double black_scholes(const Option &o, const Model &m) {
+  int n = m.steps;
+  double t = n * m.dt, rate = 0, var = 0;
+  for (int i = 0; i < n; i++) {
+    rate += m.rates[i];
+    var += m.vols[i] * m.vols[i];
+  }
+
+  // scratch from the thread's arena, this runs alongside every control variate rollback
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+  std::pmr::vector<double> scale(&arena), escrow(&arena);
+  scale.reserve(n + 1);
+  escrow.reserve(n + 1);
+  dividend_adjustments(m, scale, escrow);
+
+  return black_scholes(o.side, (o.spot - escrow[0]) * scale[n], o.strike, t, rate / n, m.yield, std::sqrt(var / n));
+}
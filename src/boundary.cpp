@@ -0,0 +1,196 @@
+#include "boundary.hpp"
+#include "blackscholes.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+float Boundary::at(float t) const {
+  if (t <= time.front()) {
+    return spot.front();
+  } else if (t >= time.back()) {
+    return spot.back();
+  }
+
+  int k = std::upper_bound(time.begin(), time.end(), t) - time.begin() - 1;
+  float a = spot[k], b = spot[k + 1];
+
+  // no exercise on one side (0 or infinity), take the nearer point rather than interpolating towards it
+  if (a == 0 || b == 0 || std::isinf(a) || std::isinf(b)) {
+    return t - time[k] < time[k + 1] - t ? a : b;
+  }
+
+  float w = (t - time[k]) / (time[k + 1] - time[k]);
+  return a + w * (b - a);
+}
+
+Boundary exercise_boundary(const Option &o, std::stop_token stop) {
+  if (o.type != Type::American) {
+    throw std::invalid_argument("exercise boundary is only defined for american options");
+  }
+
+  // full rollback in double on an unpruned lattice, as the boundary can sit in the pruned tails (the constructor
+  // times itself as setup)
+  Model m = o.model;
+  m.prune = 0;
+  BasicLattice<double> l(m, o.spot, o.strike);
+
+  BOPM_TIME(Phase::Rollback);
+
+  int n = l.steps;
+  bool call = o.side == Side::Call;
+  double sign = call ? 1 : -1;
+  float none = call ? std::numeric_limits<float>::infinity() : 0;
+
+  Boundary b;
+  b.side = o.side;
+  b.strike = o.strike;
+  b.time.resize(n + 1);
+  b.spot.resize(n + 1);
+
+  double var = 0;
+  for (int i = 0; i < n; i++) {
+    var += m.vols[i] * m.vols[i];
+  }
+  b.vol = std::sqrt(var / n);
+
+  // just before expiration exercise is optimal once the payout beats carrying the option to expiration,
+  // which is the strike scaled by r / q when the yield outweighs the rate (puts) or vice versa (calls)
+  double r = m.rates[n - 1], q = m.yield;
+  b.time[n] = n * l.dt;
+  if (call) {
+    b.spot[n] = q > 0 ? o.strike * std::max(1.0, r / q) : none;
+  } else {
+    b.spot[n] = r > 0 ? o.strike * std::min(1.0, q > 0 ? r / q : 1.0) : none;
+  }
+
+  // the lattice's own rollback, reading each earlier step's continuation values as it goes
+  rollback<double>(o, l, [&](const Slice<double> &s) {
+    if (stop.stop_requested()) {
+      throw Cancelled();
+    }
+
+    int i = s.step;
+    if (i == n) {
+      return;
+    }
+
+    // exercised nodes are contiguous from the bottom of the step (puts) or the top (calls), find the last
+    // exercised node and interpolate where continuation - payout crosses zero towards the next one (payouts
+    // in double, as in the rollback)
+    auto payout = [&](int j) { return std::max(sign * (s.spot[j] - o.strike), 0.0); };
+    auto gap = [&](int j) { return s.cont[j] - payout(j); };
+    auto exercised = [&](int j) { return gap(j) < 0 && payout(j) > 0; };
+
+    int edge = -1, next = -1;
+    if (call) {
+      for (int j = i; j >= 0 && exercised(j); j--) {
+        edge = j;
+      }
+      next = edge - 1;
+    } else {
+      for (int j = 0; j <= i && exercised(j); j++) {
+        edge = j;
+      }
+      next = edge + 1;
+    }
+
+    b.time[i] = i * l.dt;
+    if (edge < 0) {
+      b.spot[i] = none;
+    } else if (next < 0 || next > i) {
+      b.spot[i] = s.spot[edge]; // every node exercised
+    } else {
+      double g0 = gap(edge), g1 = gap(next), s0 = s.spot[edge], s1 = s.spot[next];
+      b.spot[i] = s0 + (s1 - s0) * -g0 / (g1 - g0);
+    }
+  });
+
+  return b;
+}
+
+float boundary_price(const Option &o, const Boundary &b, int nodes) {
+  const Model &m = o.model;
+  if (!m.dividends.empty()) {
+    throw std::invalid_argument("boundary pricing does not support discrete dividends");
+  }
+
+  BOPM_TIME(Phase::Rollback);
+
+  // integrated rate and variance at each step, piecewise linear in between
+  int n = m.steps;
+  std::vector<double> R(n + 1, 0), V(n + 1, 0);
+  for (int i = 0; i < n; i++) {
+    R[i + 1] = R[i] + m.rates[i] * m.dt;
+    V[i + 1] = V[i] + m.vols[i] * m.vols[i] * m.dt;
+  }
+
+  double T = n * m.dt, q = m.yield, S = o.spot, K = o.strike;
+  double sign = o.side == Side::Call ? 1 : -1;
+
+  // european price over the flat rate and vol with the same integrals
+  double vol = std::sqrt(V[n] / T);
+  double price = black_scholes(o.side, S, K, T, R[n] / T, q, vol);
+
+  // rescale the boundary's log distance from its expiration value to the current vol
+  double end = b.spot.back(), scale = b.vol > 0 ? vol / b.vol : 1;
+  if (end == 0 || std::isinf(end)) {
+    end = K;
+  }
+
+  // premium, substituting t = T u^2 concentrates points near now, where the integrand moves fastest when
+  // spot sits near the boundary
+  double premium = 0;
+  for (int k = 0; k < nodes; k++) {
+    double u = (k + 0.5) / nodes, t = T * u * u, w = 2 * T * u / nodes;
+
+    double B = b.at(t);
+    if (B == 0 || std::isinf(B)) {
+      continue;
+    }
+    B = end * std::pow(B / end, scale);
+
+    int i = std::min((int)(t / m.dt), n - 1);
+    double f = t / m.dt - i;
+    double Rt = R[i] + f * (R[i + 1] - R[i]), Vt = V[i] + f * (V[i + 1] - V[i]);
+
+    double d2 = (std::log(S / B) + Rt - q * t - Vt / 2) / std::sqrt(Vt), d1 = d2 + std::sqrt(Vt);
+    premium += w * sign * (q * S * std::exp(-q * t) * norm_cdf(sign * d1) - m.rates[i] * K * std::exp(-Rt) * norm_cdf(sign * d2));
+  }
+
+  return price + premium;
+}
+
+BoundaryPricer::BoundaryPricer(const Option &o, float st, float vt) : spot0(o.spot), shift0(0), shift(0), spot_tol(st), vol_tol(vt), rebuilt(0) {
+  static_cast<Option &>(option) = o;
+  vols = o.model.vols;
+  cached = exercise_boundary(option);
+  rebuilt++;
+}
+
+float BoundaryPricer::price(float spot, float vol_shift) {
+  option.spot = spot;
+
+  if (vol_shift != shift) {
+    for (int i = 0; i < vols.size(); i++) {
+      option.model.vols[i] = vols[i] + vol_shift;
+    }
+    shift = vol_shift;
+  }
+
+  if (std::abs(spot / spot0 - 1) > spot_tol || std::abs(vol_shift - shift0) > vol_tol) {
+    cached = exercise_boundary(option);
+    spot0 = spot;
+    shift0 = vol_shift;
+    rebuilt++;
+  }
+
+  return boundary_price(option, cached);
+}
+
+long BoundaryPricer::rebuilds() const { return rebuilt; }
+
+const Boundary &BoundaryPricer::boundary() const { return cached; }
@@ -0,0 +1,138 @@
+#include "cache.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+
+LatticeCache::LatticeCache(size_t c) : capacity(c), held(0), hit_count(0), miss_count(0) {}
+
+namespace {
+
+uint32_t word(float f) { return f == 0 ? 0 : std::bit_cast<uint32_t>(f); }
+
+thread_local int bypassed = 0;
+
+} // namespace
+
+size_t LatticeCache::Hash::operator()(const Key &k) const {
+  uint64_t h = 14695981039346656037ull;
+  h = (h ^ (uint32_t)k.scalar) * 1099511628211ull;
+  h = (h ^ (uint32_t)k.steps) * 1099511628211ull;
+  for (uint32_t w : k.words) {
+    h = (h ^ w) * 1099511628211ull;
+  }
+  return h;
+}
+
+// flattens everything the lattice is built from into k, reusing its storage
+void LatticeCache::key(Key &k, const Model &m, float spot, float strike, int scalar) {
+  if (m.rates.size() < m.steps || m.vols.size() < m.steps) {
+    throw std::invalid_argument("model has fewer rates or vols than steps");
+  }
+
+  k.scalar = scalar; // float and double lattices are kept apart
+  k.steps = m.steps;
+
+  std::vector<uint32_t> &w = k.words;
+  w.clear();
+  w.push_back(word(m.dt));
+  std::transform(m.rates.begin(), m.rates.begin() + m.steps, std::back_inserter(w), word);
+  std::transform(m.vols.begin(), m.vols.begin() + m.steps, std::back_inserter(w), word);
+  w.push_back(word(m.yield));
+  w.push_back((uint32_t)m.param);
+  w.push_back(word(m.prune));
+
+  for (const Dividend &d : m.dividends) {
+    w.push_back(word(d.time));
+    w.push_back(word(d.amount));
+    w.push_back((uint32_t)d.type);
+  }
+
+  if (m.param == Param::LR) {
+    w.push_back(word(spot));
+    w.push_back(word(strike));
+  }
+}
+
+template <typename T> std::shared_ptr<const BasicLattice<T>> LatticeCache::get(const Model &m, float spot, float strike) {
+  // the key is built into a per thread buffer, so lookups allocate nothing once it has grown
+  thread_local Key k;
+  key(k, m, spot, strike, sizeof(T));
+
+  if (bypassed) {
+    return std::make_shared<const BasicLattice<T>>(m, spot, strike);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = index.find(k);
+    if (it != index.end()) {
+      order.splice(order.begin(), order, it->second);
+      hit_count.fetch_add(1, std::memory_order_relaxed);
+      return std::get<std::shared_ptr<const BasicLattice<T>>>(it->second->value);
+    }
+  }
+
+  // built outside the lock so a slow setup doesn't hold up lookups, two threads missing on the same key both
+  // build and the second insert is dropped
+  miss_count.fetch_add(1, std::memory_order_relaxed);
+  auto l = std::make_shared<const BasicLattice<T>>(m, spot, strike);
+
+  size_t bytes = sizeof(T) * (l->uProb.size() + l->disc.size() + l->centre.size() + l->escrow.size()) + sizeof(int) * (l->lo.size() + l->hi.size());
+  insert(k, l, bytes);
+
+  return l;
+}
+
+void LatticeCache::insert(const Key &k, Value v, size_t bytes) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (index.contains(k) || bytes > capacity) {
+    return;
+  }
+
+  order.push_front({k, std::move(v), bytes});
+  index.emplace(k, order.begin());
+  held += bytes;
+
+  while (held > capacity) {
+    held -= order.back().bytes;
+    index.erase(order.back().key);
+    order.pop_back();
+  }
+}
+
+long LatticeCache::hits() const { return hit_count.load(std::memory_order_relaxed); }
+
+long LatticeCache::misses() const { return miss_count.load(std::memory_order_relaxed); }
+
+size_t LatticeCache::size() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return order.size();
+}
+
+size_t LatticeCache::bytes() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return held;
+}
+
+void LatticeCache::clear() {
+  std::lock_guard<std::mutex> guard(lock);
+  order.clear();
+  index.clear();
+  held = 0;
+  hit_count = 0;
+  miss_count = 0;
+}
+
+LatticeCache::Bypass::Bypass() { bypassed++; }
+
+LatticeCache::Bypass::~Bypass() { bypassed--; }
+
+LatticeCache &LatticeCache::global() {
+  static LatticeCache cache;
+  return cache;
+}
+
+template std::shared_ptr<const BasicLattice<float>> LatticeCache::get<float>(const Model &, float, float);
+template std::shared_ptr<const BasicLattice<double>> LatticeCache::get<double>(const Model &, float, float);
@@ -0,0 +1,135 @@
+#include "fdm.hpp"
+#include "arena.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "options.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+
+FiniteDifference::FiniteDifference() {}
+
+FiniteDifference::FiniteDifference(const Model &m, float spot, int n, std::pmr::memory_resource *mem)
+    : rates(mem), vols(mem), scale(mem), escrow(mem) {
+  BOPM_TIME(Phase::Setup);
+
+  steps = m.steps;
+  dt = m.dt;
+  rates.assign(m.rates.begin(), m.rates.begin() + steps);
+  vols.assign(m.vols.begin(), m.vols.begin() + steps);
+  yield = m.yield;
+
+  std::pmr::vector<double> s(mem), e(mem);
+  dividend_adjustments(m, s, e);
+  scale.assign(s.begin(), s.end());
+  escrow.assign(e.begin(), e.end());
+
+  // odd node count so spot sits on the centre node
+  nodes = std::max(n > 0 ? n : steps, 101) | 1;
+
+  // grid spans 5 standard deviations either side of spot, using the largest vol
+  float vmax = *std::max_element(vols.begin(), vols.end());
+  float width = 5 * vmax * std::sqrt(steps * dt);
+
+  dx = 2 * width / (nodes - 1);
+  xmin = std::log(spot - escrow[0]) - width;
+}
+
+FdResult solve(const Option &o, const FiniteDifference &fd) {
+  BOPM_TIME(Phase::Rollback);
+  BOPM_COUNT(nodes, (long)fd.nodes * (fd.steps + 1));
+
+  int n = fd.nodes;
+  bool american = o.type == Type::American;
+  double sign = o.side == Side::Call ? 1 : -1;
+
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  std::pmr::vector<double> x(n, &arena), v(n, &arena), rhs(n, &arena), diag(n, &arena), ex(n, &arena), prev(&arena);
+  for (int j = 0; j < n; j++) {
+    x[j] = std::exp(fd.xmin + j * fd.dx);
+    v[j] = o.payout(x[j] * fd.scale[fd.steps] + fd.escrow[fd.steps]);
+  }
+
+  double R = 0, Q = 0; // integrated rate and yield from the current step to expiration
+  for (int i = fd.steps - 1; i >= 0; i--) {
+    Progress::step();
+
+    double r = fd.rates[i], s2 = fd.vols[i] * fd.vols[i];
+    double nu = r - fd.yield - s2 / 2;
+
+    // L v[j] = a v[j - 1] + b v[j] + c v[j + 1]
+    double a = s2 / (2 * fd.dx * fd.dx) - nu / (2 * fd.dx);
+    double b = -s2 / (fd.dx * fd.dx) - r;
+    double c = s2 / (2 * fd.dx * fd.dx) + nu / (2 * fd.dx);
+
+    // the first two steps are fully implicit (rannacher), damping oscillations from the payout kink
+    double theta = i >= fd.steps - 2 ? 1 : 0.5;
+
+    for (int j = 1; j < n - 1; j++) {
+      rhs[j] = v[j] + (1 - theta) * fd.dt * (a * v[j - 1] + b * v[j] + c * v[j + 1]);
+    }
+
+    R += r * fd.dt;
+    Q += fd.yield * fd.dt;
+
+    // far boundaries take the discounted forward intrinsic value (or exercise value if higher)
+    for (int j : {0, n - 1}) {
+      v[j] = std::max(sign * (x[j] * fd.scale[fd.steps] * std::exp(-Q) - o.strike * std::exp(-R)), 0.0);
+      if (american) {
+        v[j] = std::max(v[j], (double)o.payout(x[j] * fd.scale[i] + fd.escrow[i]));
+      }
+    }
+
+    for (int j = 1; j < n - 1; j++) {
+      ex[j] = american ? o.payout(x[j] * fd.scale[i] + fd.escrow[i]) : -INFINITY;
+    }
+
+    // tridiagonal system lo v[j - 1] + di v[j] + up v[j + 1] = rhs[j] over the interior nodes
+    double lo = -theta * fd.dt * a, di = 1 - theta * fd.dt * b, up = -theta * fd.dt * c;
+    rhs[1] -= lo * v[0];
+    rhs[n - 2] -= up * v[n - 1];
+
+    // brennan-schwartz, eliminate away from the exercise region then substitute towards it applying the
+    // early exercise constraint (puts exercise at low spot, calls at high spot), plain thomas when european
+    if (sign < 0) {
+      diag[n - 2] = di;
+      for (int j = n - 3; j >= 1; j--) {
+        double m = up / diag[j + 1];
+        diag[j] = di - m * lo;
+        rhs[j] -= m * rhs[j + 1];
+      }
+      for (int j = 1; j < n - 1; j++) {
+        v[j] = std::max((rhs[j] - (j > 1 ? lo * v[j - 1] : 0)) / diag[j], ex[j]);
+      }
+    } else {
+      diag[1] = di;
+      for (int j = 2; j < n - 1; j++) {
+        double m = lo / diag[j - 1];
+        diag[j] = di - m * up;
+        rhs[j] -= m * rhs[j - 1];
+      }
+      for (int j = n - 2; j >= 1; j--) {
+        v[j] = std::max((rhs[j] - (j < n - 2 ? up * v[j + 1] : 0)) / diag[j], ex[j]);
+      }
+    }
+
+    if (i == 1) {
+      prev = v; // kept for theta
+    }
+  }
+
+  // greeks by finite differences on the grid around the centre node (spot)
+  int m = n / 2;
+  double s = x[m] + fd.escrow[0], su = x[m + 1] + fd.escrow[0], sd = x[m - 1] + fd.escrow[0];
+  double du = (v[m + 1] - v[m]) / (su - s), dd = (v[m] - v[m - 1]) / (s - sd);
+
+  FdResult res;
+  res.price = v[m];
+  res.delta = (v[m + 1] - v[m - 1]) / (su - sd);
+  res.gamma = 2 * (du - dd) / (su - sd);
+  res.theta = fd.steps > 1 ? (prev[m] - v[m]) / fd.dt : 0;
+
+  return res;
+}
@@ -0,0 +1,169 @@
+#include "instrument.hpp"
+#include <format>
+#include <mutex>
+#include <vector>
+
+std::string phase_str(Phase p) {
+  if (p == Phase::Setup) {
+    return "Setup";
+
+  } else if (p == Phase::Rollback) {
+    return "Rollback";
+
+  } else if (p == Phase::Greeks) {
+    return "Greeks";
+
+  } else if (p == Phase::Parse) {
+    return "Parse";
+
+  } else if (p == Phase::Serialise) {
+    return "Serialise";
+
+  } else if (p == Phase::Fetch) {
+    return "Fetch";
+
+  } else {
+    return "?";
+  }
+}
+
+namespace instrument {
+
+namespace {
+
+// plain sum of every thread's counters
+struct Totals {
+  long calls[(int)Phase::Count] = {};
+  long ns[(int)Phase::Count] = {};
+  long nodes = 0, allocations = 0, bytes = 0, blocks = 0;
+
+  void add(const Counters &c, long sign = 1) {
+    for (int i = 0; i < (int)Phase::Count; i++) {
+      calls[i] += sign * c.calls[i].load(std::memory_order_relaxed);
+      ns[i] += sign * c.ns[i].load(std::memory_order_relaxed);
+    }
+    nodes += sign * c.nodes.load(std::memory_order_relaxed);
+    allocations += sign * c.allocations.load(std::memory_order_relaxed);
+    bytes += sign * c.bytes.load(std::memory_order_relaxed);
+    blocks += sign * c.blocks.load(std::memory_order_relaxed);
+  }
+
+  void add(const Totals &t, long sign = 1) {
+    for (int i = 0; i < (int)Phase::Count; i++) {
+      calls[i] += sign * t.calls[i];
+      ns[i] += sign * t.ns[i];
+    }
+    nodes += sign * t.nodes;
+    allocations += sign * t.allocations;
+    bytes += sign * t.bytes;
+    blocks += sign * t.blocks;
+  }
+};
+
+// every live thread's counters, what exited threads counted, and the totals at the last reset
+struct Registry {
+  std::mutex m;
+  std::vector<const Counters *> live;
+  Totals retired, baseline;
+
+  Totals raw() {
+    Totals t = retired;
+    for (const Counters *c : live) {
+      t.add(*c);
+    }
+    return t;
+  }
+};
+
+// never destroyed, threads can exit after static destruction has begun
+Registry &registry() {
+  static Registry *r = new Registry;
+  return *r;
+}
+
+// a thread's counters, registered for as long as the thread runs
+struct Local {
+  Counters counters{};
+
+  Local() {
+    Registry &r = registry();
+    std::lock_guard lock(r.m);
+    r.live.push_back(&counters);
+  }
+
+  ~Local() {
+    Registry &r = registry();
+    std::lock_guard lock(r.m);
+    r.retired.add(counters);
+    std::erase(r.live, &counters);
+  }
+};
+
+thread_local int paused = 0;
+
+Totals totals() {
+  Registry &r = registry();
+  std::lock_guard lock(r.m);
+  Totals t = r.raw();
+  t.add(r.baseline, -1);
+  return t;
+}
+
+} // namespace
+
+Counters &counters() {
+  thread_local Local local;
+  thread_local Counters discard{}; // counted while paused, never read
+  return paused ? discard : local.counters;
+}
+
+Pause::Pause() { paused++; }
+Pause::~Pause() { paused--; }
+
+Timer::~Timer() {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  Counters &c = counters();
+  add(c.calls[(int)phase], 1);
+  add(c.ns[(int)phase], ns);
+}
+
+void reset() {
+  Registry &r = registry();
+  std::lock_guard lock(r.m);
+  r.baseline = r.raw();
+}
+
+nlohmann::json to_json() {
+  Totals c = totals();
+  nlohmann::json data;
+
+  data["enabled"] = (bool)BOPM_INSTRUMENT;
+  for (int i = 0; i < (int)Phase::Count; i++) {
+    data["phases"][phase_str((Phase)i)] = {{"calls", c.calls[i]}, {"ms", c.ns[i] / 1e6}};
+  }
+  data["nodes"] = c.nodes;
+  data["allocations"] = c.allocations;
+  data["bytes"] = c.bytes;
+  data["blocks"] = c.blocks;
+
+  return data;
+}
+
+std::string report() {
+  if (!BOPM_INSTRUMENT) {
+    return "Instrumentation\n\tdisabled at compile time (BOPM_INSTRUMENT=0)\n";
+  }
+
+  Totals c = totals();
+
+  std::string str = "Instrumentation\n";
+  for (int i = 0; i < (int)Phase::Count; i++) {
+    str += std::format("\t{:<20} : {} calls, {:.3f} ms\n", phase_str((Phase)i), c.calls[i], c.ns[i] / 1e6);
+  }
+  str += std::format("\t{:<20} : {}\n", "Nodes", c.nodes);
+  str += std::format("\t{:<20} : {} ({} bytes, {} heap blocks)\n", "Allocations", c.allocations, c.bytes, c.blocks);
+
+  return str;
+}
+
+} // namespace instrument
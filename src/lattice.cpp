@@ -0,0 +1,324 @@
+#include "lattice.hpp"
+#include "arena.hpp"
+#include "blackscholes.hpp"
+#include "instrument.hpp"
+#include "options.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// values deep out of the money underflow into denormals at high step counts, which are handled in microcode
+// and slow the rollback by an order of magnitude, flush them to zero for the duration of a rollback
+struct FlushDenormals {
+#if defined(__SSE__)
+  unsigned int csr = _mm_getcsr();
+  FlushDenormals() { _mm_setcsr(csr | 0x8040); } // flush to zero and denormals are zero
+  ~FlushDenormals() { _mm_setcsr(csr); }
+#endif
+};
+
+} // namespace
+
+template <typename T>
+BasicLattice<T>::BasicLattice(std::pmr::memory_resource *mem) : steps(0), dt(0), ratio(1), uProb(mem), disc(mem), centre(mem), escrow(mem), prune(0), lo(mem), hi(mem) {}
+
+template <typename T>
+BasicLattice<T>::BasicLattice(const Model &m, float spot, float strike, std::pmr::memory_resource *mem)
+    : uProb(mem), disc(mem), centre(mem), escrow(mem), lo(mem), hi(mem) {
+  BOPM_TIME(Phase::Setup);
+
+  if (m.param == Param::JR) {
+    build<JR>(m, spot, strike);
+  } else if (m.param == Param::Tian) {
+    build<Tian>(m, spot, strike);
+  } else if (m.param == Param::LR) {
+    build<LR>(m, spot, strike);
+  } else /* CRR */ {
+    build<CRR>(m, spot, strike);
+  }
+}
+
+template <typename T> long BasicLattice<T>::nodes() const {
+  long n = 0;
+  for (int i = 0; i <= steps; i++) {
+    n += hi[i] - lo[i] + 1;
+  }
+  return n;
+}
+
+template <typename T> float BasicLattice<T>::truncation_bound(float spot, float strike) const {
+  if (prune <= 0) {
+    return 0;
+  }
+
+  // only paths leaving the band can be mispriced, at most with probability 2N(-k) and by the size of the payout
+  return std::erfc(prune / std::numbers::sqrt2) * (spot + strike);
+}
+
+void dividend_adjustments(const Model &m, std::pmr::vector<double> &scale, std::pmr::vector<double> &escrow) {
+  int steps = m.steps;
+  float dt = m.dt;
+
+  // cumulative rate integral at each step, used to discount cash dividends between steps
+  std::pmr::vector<double> growth(steps + 1, 0, scale.get_allocator());
+  for (int i = 0; i < steps; i++) {
+    growth[i + 1] = growth[i] + m.rates[i] * dt;
+  }
+  auto integral = [&](float t) {
+    int i = std::min((int)(t / dt), steps - 1);
+    return growth[i] + m.rates[i] * (t - i * dt);
+  };
+
+  scale.assign(steps + 1, 1);
+  escrow.assign(steps + 1, 0);
+  for (int i = 0; i <= steps; i++) {
+    double t = i * dt;
+
+    for (const Dividend &div : m.dividends) {
+      if (div.time <= 0 || div.time > steps * dt) {
+        continue; // already paid, or paid after expiration
+      }
+
+      if (div.type == DividendType::Proportional && div.time <= t) {
+        scale[i] *= 1 - div.amount;
+      } else if (div.type == DividendType::Cash && div.time > t) {
+        escrow[i] += div.amount * std::exp(growth[i] - integral(div.time));
+      }
+    }
+  }
+}
+
+namespace {
+
+// backward induction specialised at compile time on exercise style and side (payout is max(Sign * (spot -
+// strike), 0)), leaving no branches in the inner loop so it vectorises, with Visit each step's spots and
+// continuation values are also written out and handed to visit
+template <bool American, int Sign, bool Visit, typename T>
+T rollback_kernel(const BasicLattice<T> &l, T spot, T strike, const SliceVisitor<T> *visit) {
+  T s0 = spot - l.escrow[0];
+
+  // node spots are s0 * centre[i] * sqrt(ratio)^(2j - i) + escrow[i], tabulating the last factor removes the
+  // loop carried dependency, entries beyond the range of T (inf or 0) are only read at nodes whose spots are
+  // too, which check() refuses for float lattices
+  int n = l.steps;
+  T h = std::sqrt(l.ratio);
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  std::pmr::vector<T> pw(2 * n + 1, &arena);
+  for (int k = 0; k <= 2 * n; k++) {
+    pw[k] = std::pow(h, k - n);
+  }
+
+  std::pmr::vector<T> sp(&arena), cont(&arena); // only written when visiting
+  if constexpr (Visit) {
+    sp.resize(n + 1);
+    cont.resize(n + 1);
+  }
+
+  // option values at the expiration step (including a node either side of the band, if pruned)
+  std::pmr::vector<T> v(n + 1, &arena);
+  int first = std::max(l.lo[n] - 1, 0), last = std::min(l.hi[n] + 1, n);
+
+  T fac = s0 * l.centre[n], esc = l.escrow[n];
+  const T *q = pw.data(); // q[2j] is sqrt(ratio)^(2j - i) at step i
+  for (int j = first; j <= last; j++) {
+    T s = fac * q[2 * j] + esc;
+    v[j] = std::max(Sign * (s - strike), T(0));
+
+    if constexpr (Visit) {
+      sp[j] = s;
+      cont[j] = v[j];
+    }
+  }
+
+  if constexpr (Visit) {
+    (*visit)({n, l.lo[n], l.hi[n], sp.data(), v.data(), cont.data()});
+  }
+
+  // discount and expected growth of the dividend free spot from the current step to expiration
+  T pv = 1, carry = 1;
+
+  // work backwards through the lattice, discounting expected values (and checking for early exercise)
+  for (int i = n - 1; i >= 0; i--) {
+    Progress::step();
+
+    T p = l.uProb[i], df = l.disc[i];
+    fac = s0 * l.centre[i];
+    esc = l.escrow[i];
+    q = pw.data() + (n - i);
+
+    T *vi = v.data();
+    for (int j = l.lo[i]; j <= l.hi[i]; j++) {
+      T x = df * (p * vi[j + 1] + (1 - p) * vi[j]);
+
+      if constexpr (Visit) {
+        sp[j] = fac * q[2 * j] + esc;
+        cont[j] = x;
+      }
+
+      if constexpr (American) {
+        x = std::max(x, Sign * (fac * q[2 * j] + esc - strike));
+      }
+
+      vi[j] = x;
+    }
+
+    if (l.prune > 0) {
+      pv *= df;
+      carry *= (p * l.ratio + 1 - p) * l.centre[i + 1] / (l.centre[i] * h);
+
+      // clamp the nodes just outside the band (read by the next step) to their value with no further
+      // volatility, far in the tails the payout is linear in spot so this is all but exact
+      for (int j : {l.lo[i] - 1, l.hi[i] + 1}) {
+        if (j >= 0 && j <= i) {
+          T c = pv * std::max(Sign * (fac * q[2 * j] * carry - strike), T(0));
+
+          if constexpr (American) {
+            c = std::max(c, Sign * (fac * q[2 * j] + esc - strike));
+          }
+
+          v[j] = c;
+        }
+      }
+    }
+
+    if constexpr (Visit) {
+      (*visit)({i, l.lo[i], l.hi[i], sp.data(), v.data(), cont.data()});
+    }
+  }
+
+  return v[0];
+}
+
+// single dispatch to the specialised kernel
+template <bool Visit, typename T> T dispatch(const Option &o, const BasicLattice<T> &l, const SliceVisitor<T> *visit) {
+  bool american = o.type == Type::American, call = o.side == Side::Call;
+  if (american) {
+    return call ? rollback_kernel<true, 1, Visit, T>(l, o.spot, o.strike, visit) : rollback_kernel<true, -1, Visit, T>(l, o.spot, o.strike, visit);
+  } else {
+    return call ? rollback_kernel<false, 1, Visit, T>(l, o.spot, o.strike, visit) : rollback_kernel<false, -1, Visit, T>(l, o.spot, o.strike, visit);
+  }
+}
+
+// american and european rollback fused into one sweep (see rollback_kernel), both lanes read the same
+// probabilities, discount factors and node spots, so the european costs one more multiply-add per node
+// rather than a second pass over the lattice, returns {american, european}
+template <int Sign, typename T> std::pair<T, T> rollback_cv_kernel(const BasicLattice<T> &l, T spot, T strike, T vol) {
+  T s0 = spot - l.escrow[0];
+
+  int n = l.steps;
+  T h = std::sqrt(l.ratio);
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  std::pmr::vector<T> pw(2 * n + 1, &arena);
+  for (int k = 0; k <= 2 * n; k++) {
+    pw[k] = std::pow(h, k - n);
+  }
+
+  // the last step is smoothed with black-scholes (bbs): instead of the payoff's kink landing on or between
+  // nodes, which makes the lattice error oscillate with the parity of the step count, every node one step
+  // from expiration takes the closed form continuation value over dt on the lattice's own forward and
+  // discount, so both lanes converge smoothly and their errors line up
+  std::pmr::vector<T> a(n + 1, &arena), e(n + 1, &arena);
+  int first = std::max(l.lo[n - 1] - 1, 0), last = std::min(l.hi[n - 1] + 1, n - 1);
+
+  T p = l.uProb[n - 1], df = l.disc[n - 1];
+  T pv = df, carry = (p * l.ratio + 1 - p) * l.centre[n] / (l.centre[n - 1] * h);
+  T fac = s0 * l.centre[n - 1], esc = l.escrow[n - 1];
+  const T *q = pw.data() + 1;
+  for (int j = first; j <= last; j++) {
+    T x = fac * q[2 * j];
+    T c = df * black_scholes(Sign > 0 ? Side::Call : Side::Put, std::max(x * carry, T(0)), strike, l.dt, 0, 0, vol);
+    a[j] = std::max(c, Sign * (x + esc - strike));
+    e[j] = c;
+  }
+
+  for (int i = n - 2; i >= 0; i--) {
+    Progress::step();
+
+    p = l.uProb[i];
+    df = l.disc[i];
+    fac = s0 * l.centre[i];
+    esc = l.escrow[i];
+    q = pw.data() + (n - i);
+
+    T *ai = a.data(), *ei = e.data();
+    for (int j = l.lo[i]; j <= l.hi[i]; j++) {
+      T x = df * (p * ai[j + 1] + (1 - p) * ai[j]);
+      ai[j] = std::max(x, Sign * (fac * q[2 * j] + esc - strike));
+      ei[j] = df * (p * ei[j + 1] + (1 - p) * ei[j]);
+    }
+
+    if (l.prune > 0) {
+      pv *= df;
+      carry *= (p * l.ratio + 1 - p) * l.centre[i + 1] / (l.centre[i] * h);
+
+      for (int j : {l.lo[i] - 1, l.hi[i] + 1}) {
+        if (j >= 0 && j <= i) {
+          T c = pv * std::max(Sign * (fac * q[2 * j] * carry - strike), T(0));
+          a[j] = std::max(c, Sign * (fac * q[2 * j] + esc - strike));
+          e[j] = c;
+        }
+      }
+    }
+  }
+
+  return {a[0], e[0]};
+}
+
+} // namespace
+
+template <typename T> T rollback(const Option &o, const BasicLattice<T> &l) {
+  BOPM_TIME(Phase::Rollback);
+  BOPM_COUNT(nodes, l.nodes());
+  FlushDenormals ftz;
+
+  return dispatch<false, T>(o, l, nullptr);
+}
+
+template <typename T> T rollback(const Option &o, const BasicLattice<T> &l, const std::type_identity_t<SliceVisitor<T>> &visit) {
+  FlushDenormals ftz;
+
+  return dispatch<true, T>(o, l, &visit);
+}
+
+template <typename T> T rollback_cv(const Option &o, const BasicLattice<T> &l, double european) {
+  if (o.type != Type::American) {
+    return european; // the correction is exact
+  }
+
+  BOPM_TIME(Phase::Rollback);
+  BOPM_COUNT(nodes, l.nodes());
+  FlushDenormals ftz;
+
+  // smoothed with the rms vol over all steps, the one the node spacing and the european's closed form use
+  double var = 0;
+  for (int i = 0; i < l.steps; i++) {
+    var += (double)o.model.vols[i] * o.model.vols[i];
+  }
+
+  T vol = std::sqrt(var / l.steps);
+  auto [a, e] = o.side == Side::Call ? rollback_cv_kernel<1, T>(l, o.spot, o.strike, vol) : rollback_cv_kernel<-1, T>(l, o.spot, o.strike, vol);
+  return a - e + european;
+}
+
+template class BasicLattice<float>;
+template class BasicLattice<double>;
+
+template float rollback<float>(const Option &o, const BasicLattice<float> &l);
+template double rollback<double>(const Option &o, const BasicLattice<double> &l);
+
+template float rollback<float>(const Option &o, const BasicLattice<float> &l, const SliceVisitor<float> &visit);
+template double rollback<double>(const Option &o, const BasicLattice<double> &l, const SliceVisitor<double> &visit);
+
+template float rollback_cv<float>(const Option &o, const BasicLattice<float> &l, double european);
+template double rollback_cv<double>(const Option &o, const BasicLattice<double> &l, double european);
@@ -0,0 +1,192 @@
+#include "lattice2d.hpp"
+#include "arena.hpp"
+#include "instrument.hpp"
+#include "options.hpp"
+#include "pool.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+Lattice2D::Lattice2D() {}
+
+Lattice2D::Lattice2D(const RainbowOption &o, std::pmr::memory_resource *mem) : puu(mem), pud(mem), pdu(mem), pdd(mem), disc(mem) {
+  BOPM_TIME(Phase::Setup);
+
+  const Model &m = o.model[0];
+  steps = m.steps;
+  dt = m.dt;
+
+  if (o.model[1].steps != steps || o.model[1].dt != m.dt) {
+    throw std::invalid_argument("rainbow option models must have the same steps and expiration");
+  }
+  // both underlyings are discounted and drift at one rate, the first model's
+  if (m.rates.size() < steps || o.model[1].rates.size() < steps || !std::equal(m.rates.begin(), m.rates.begin() + steps, o.model[1].rates.begin())) {
+    throw std::invalid_argument("rainbow option models must have the same rate at every step");
+  }
+  if (!o.model[0].dividends.empty() || !o.model[1].dividends.empty()) {
+    throw std::invalid_argument("rainbow options do not support discrete dividends");
+  }
+
+  // node spacing from each underlying's rms vol, so slices recombine
+  double up[2];
+  for (int a = 0; a < 2; a++) {
+    double var = 0;
+    for (int i = 0; i < steps; i++) {
+      var += (double)o.model[a].vols[i] * o.model[a].vols[i];
+    }
+    up[a] = std::exp(std::sqrt(var / steps * dt));
+    down[a] = 1 / up[a];
+    ratio[a] = up[a] / down[a];
+  }
+
+  puu.resize(steps);
+  pud.resize(steps);
+  pdu.resize(steps);
+  pdd.resize(steps);
+  disc.resize(steps);
+  for (int i = 0; i < steps; i++) {
+    double p1 = (std::exp((m.rates[i] - o.model[0].yield) * dt) - down[0]) / (up[0] - down[0]);
+    double p2 = (std::exp((m.rates[i] - o.model[1].yield) * dt) - down[1]) / (up[1] - down[1]);
+    double cov = o.correlation * std::sqrt(p1 * (1 - p1) * p2 * (1 - p2));
+
+    puu[i] = p1 * p2 + cov;
+    pud[i] = p1 * (1 - p2) - cov;
+    pdu[i] = (1 - p1) * p2 - cov;
+    pdd[i] = (1 - p1) * (1 - p2) + cov;
+    disc[i] = std::exp(-m.rates[i] * dt);
+
+    if (std::min({puu[i], pud[i], pdu[i], pdd[i]}) < 0) {
+      throw std::invalid_argument("correlation too close to +-1 for the step size, increase steps");
+    }
+  }
+}
+
+long Lattice2D::nodes() const {
+  long n = 0;
+  for (long i = 0; i <= steps; i++) {
+    n += (i + 1) * (i + 1);
+  }
+  return n;
+}
+
+namespace {
+
+template <RainbowPayoff P> double combine(const RainbowOption &o, double s1, double s2) {
+  if constexpr (P == RainbowPayoff::Spread) {
+    return o.weight[0] * s1 - o.weight[1] * s2;
+  } else if constexpr (P == RainbowPayoff::Basket) {
+    return o.weight[0] * s1 + o.weight[1] * s2;
+  } else if constexpr (P == RainbowPayoff::BestOf) {
+    return std::max(s1, s2);
+  } else /* WorstOf */ {
+    return std::min(s1, s2);
+  }
+}
+
+constexpr int tile = 512; // columns per tile, two rows of doubles in 8kb
+
+// backward induction specialised at compile time on exercise style, side and payoff (as the binomial
+// kernels), so the inner loop over a row has no branches and vectorises
+template <bool American, int Sign, RainbowPayoff P> double rollback_kernel(const RainbowOption &o, const Lattice2D &l, int threads) {
+  int n = l.steps, w = n + 1; // slices are stored as rows of w doubles, row j holds the nodes with j up moves of the first underlying
+  double strike = o.strike;
+
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  // ratio^j for each underlying, node spots at step i are these times spot * down^i
+  std::pmr::vector<double> pw1(w, &arena), pw2(w, &arena);
+  pw1[0] = pw2[0] = 1;
+  for (int j = 1; j <= n; j++) {
+    pw1[j] = pw1[j - 1] * l.ratio[0];
+    pw2[j] = pw2[j - 1] * l.ratio[1];
+  }
+
+  std::pmr::vector<double> buf[2] = {std::pmr::vector<double>((size_t)w * w, &arena), std::pmr::vector<double>((size_t)w * w, &arena)};
+
+  double f1 = o.spot[0] * std::pow(l.down[0], n), f2 = o.spot[1] * std::pow(l.down[1], n);
+  for (int j = 0; j <= n; j++) {
+    double *v = buf[0].data() + (size_t)j * w;
+    for (int k = 0; k <= n; k++) {
+      v[k] = std::max(Sign * (combine<P>(o, f1 * pw1[j], f2 * pw2[k]) - strike), 0.0);
+    }
+  }
+
+  // step i reads the slice written by step i + 1, rows [lo, hi) of the slice are band t
+  auto band = [&](int t, int i) {
+    int rows = i + 1;
+    int lo = (long)rows * t / threads, hi = (long)rows * (t + 1) / threads;
+
+    const double *in = buf[(n - i - 1) % 2].data();
+    double *out = buf[(n - i) % 2].data();
+
+    double uu = l.puu[i], ud = l.pud[i], du = l.pdu[i], dd = l.pdd[i], df = l.disc[i];
+    double g1 = o.spot[0] * std::pow(l.down[0], i), g2 = o.spot[1] * std::pow(l.down[1], i);
+
+    for (int c0 = 0; c0 <= i; c0 += tile) {
+      int c1 = std::min(c0 + tile, i + 1);
+
+      for (int j = lo; j < hi; j++) {
+        const double *a = in + (size_t)(j + 1) * w, *b = in + (size_t)j * w;
+        double *v = out + (size_t)j * w;
+        double s1 = g1 * pw1[j];
+
+        for (int k = c0; k < c1; k++) {
+          double x = df * (uu * a[k + 1] + ud * a[k] + du * b[k + 1] + dd * b[k]);
+
+          if constexpr (American) {
+            x = std::max(x, Sign * (combine<P>(o, s1, g2 * pw2[k]) - strike));
+          }
+
+          v[k] = x;
+        }
+      }
+    }
+  };
+
+  // progress is the calling thread's, polled between steps while no band is running, each step's bands run
+  // on the shared pool and the call returns once all have, so the next step reads a finished slice
+  for (int i = n - 1; i >= 0; i--) {
+    Progress::step();
+    if (threads == 1) {
+      band(0, i);
+    } else {
+      ThreadPool::global().parallel_for(threads, [&](size_t t) { band(t, i); });
+    }
+  }
+
+  return buf[n % 2][0];
+}
+
+template <bool American, int Sign> double dispatch_payoff(const RainbowOption &o, const Lattice2D &l, int threads) {
+  if (o.payoff == RainbowPayoff::Spread) {
+    return rollback_kernel<American, Sign, RainbowPayoff::Spread>(o, l, threads);
+  } else if (o.payoff == RainbowPayoff::Basket) {
+    return rollback_kernel<American, Sign, RainbowPayoff::Basket>(o, l, threads);
+  } else if (o.payoff == RainbowPayoff::BestOf) {
+    return rollback_kernel<American, Sign, RainbowPayoff::BestOf>(o, l, threads);
+  } else /* WorstOf */ {
+    return rollback_kernel<American, Sign, RainbowPayoff::WorstOf>(o, l, threads);
+  }
+}
+
+} // namespace
+
+float rollback(const RainbowOption &o, const Lattice2D &l, int threads) {
+  BOPM_TIME(Phase::Rollback);
+  BOPM_COUNT(nodes, l.nodes());
+
+  // a band needs enough rows to be worth a worker, small lattices are rolled back on the calling thread
+  if (threads <= 0) {
+    threads = ThreadPool::global().size();
+  }
+  threads = std::clamp(l.steps / 64, 1, threads);
+
+  bool american = o.type == Type::American, call = o.side == Side::Call;
+  if (american) {
+    return call ? dispatch_payoff<true, 1>(o, l, threads) : dispatch_payoff<true, -1>(o, l, threads);
+  } else {
+    return call ? dispatch_payoff<false, 1>(o, l, threads) : dispatch_payoff<false, -1>(o, l, threads);
+  }
+}
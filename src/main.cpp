@@ -1,16 +1,98 @@
+#include "boundary.hpp"
+#include "cache.hpp"
 #include "info.hpp"
+#include "instrument.hpp"
 #include "model.hpp"
 #include "nlohmann/json.hpp"
 #include "options.hpp"
+#include "planner.hpp"
+#include "plotdata.hpp"
 #include "rw.hpp"
+#include "task.hpp"
 #include "utils.hpp"
 #include <cplotlib/plot.hpp>
+#include <chrono>
+#include <filesystem>
 #include <format>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <poll.h>
 #include <sstream>
 #include <string>
+#include <termios.h>
 #include <termui/termui.hpp>
+#include <unistd.h>
 #include <vector>
 
+namespace {
+
+// market data calls go out over the network, timed as Phase::Fetch
+template <typename F> auto fetch(F f) {
+  BOPM_TIME(Phase::Fetch);
+  return f();
+}
+
+// prices the option on a background task, redrawing the fraction of steps
+// rolled back and each refinement's price as it lands so a usable price is
+// on screen long before the full model finishes, enter takes the latest price
+// (stopping the rest) and c or q cancels (requesting a stop on stop, so work
+// started after pricing can be skipped), returns the prices it finished
+std::vector<PricingTask::Result> price_in_background(const Option &option,
+                                                     std::stop_source &stop) {
+  PricingTask task(option);
+
+  // read single keys without waiting for enter or echoing them
+  termios saved, raw;
+  tcgetattr(STDIN_FILENO, &saved);
+  raw = saved;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+  std::cout << "\033[2J\033[H"
+            << "Pricing (enter: use latest price, c: cancel)\n\n";
+
+  size_t shown = 0;
+  while (!task.done()) {
+    std::vector<PricingTask::Result> results = task.results();
+    for (; shown < results.size(); shown++) {
+      std::cout << std::format("\r\033[K{:>10} steps : {:.4f} ({:.1f} ms)\n",
+                               results[shown].steps, results[shown].price,
+                               results[shown].ms);
+    }
+    std::cout << std::format("\r\033[K{:>5.1f}% of steps rolled back",
+                             100 * task.progress())
+              << std::flush;
+
+    pollfd in{STDIN_FILENO, POLLIN, 0};
+    if (poll(&in, 1, 100) > 0) {
+      char c = 0;
+      if (read(STDIN_FILENO, &c, 1) == 1 &&
+          (c == '\n' || c == 'c' || c == 'q')) {
+        bool accept = c == '\n';
+        task.cancel();
+        if (!accept) {
+          stop.request_stop();
+          tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+          return {}; // the task is joined on the way out
+        }
+        break;
+      }
+    }
+  }
+
+  tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+
+  try {
+    task.wait();
+  } catch (const Cancelled &) {
+    // stopped before the coarsest price finished, nothing to show
+  }
+  return task.results();
+}
+
+} // namespace
+
 int main() {
   Menu m1("Binomial Option Pricing - Joshua O'Riordan",
           {"Option Pricing", "About the Project", "User Manual", "Exit"});
@@ -135,7 +217,7 @@ int main() {
                             ->currency) { // if option is not defined, or stored
                                           // currency does not match input
                   // fetch currency exchange ratio
-                  exch_rate = exchange_rate("USD", cur);
+                  exch_rate = fetch([&] { return exchange_rate("USD", cur); });
 
                   Info("Conversion Rate",
                        std::format("Fetching conversion rate...\n\n"
@@ -158,7 +240,8 @@ int main() {
 
                 else { // otherwise fetch the asset price, convert currency if
                        // required
-                  float spot = current_spot(eqt) * exch_rate;
+                  float spot =
+                      fetch([&] { return current_spot(eqt); }) * exch_rate;
                   opt_input[2] = std::to_string(spot);
 
                   Info("Latest Asset Price",
@@ -253,7 +336,7 @@ int main() {
                             ->currency) { // if option is not defined, or stored
                                           // currency does not match input
                   // fetch currency exchange ratio
-                  exch_rate = exchange_rate("USD", cur);
+                  exch_rate = fetch([&] { return exchange_rate("USD", cur); });
 
                   Info("Conversion Rate",
                        std::format("Fetching conversion rate...\n\n"
@@ -287,7 +370,8 @@ int main() {
 
                 else { // otherwise fetch the asset price, convert currency if
                        // required
-                  float spot = current_spot(eqt) * exch_rate;
+                  float spot =
+                      fetch([&] { return current_spot(eqt); }) * exch_rate;
                   opt_input[2] = std::to_string(spot);
 
                   Info("Latest Asset Price",
@@ -369,7 +453,7 @@ int main() {
                             ->currency) { // if option is not defined, or stored
                                           // currency does not match input
                   // fetch currency exchange ratio
-                  exch_rate = exchange_rate("USD", cur);
+                  exch_rate = fetch([&] { return exchange_rate("USD", cur); });
 
                   Info("Conversion Rate",
                        std::format("Fetching conversion rate...\n\n"
@@ -403,7 +487,8 @@ int main() {
 
                 else { // otherwise fetch the asset price, convert currency if
                        // required
-                  float spot = current_spot(eqt) * exch_rate;
+                  float spot =
+                      fetch([&] { return current_spot(eqt); }) * exch_rate;
                   opt_input[2] = std::to_string(spot);
 
                   Info("Latest Asset Price",
@@ -498,15 +583,21 @@ int main() {
 
             if (t3m == 0) /* manual model param entry */ {
               std::vector<std::string> mod_fields{
-                  "Steps", "Risk Free Rate (float)", "Volatility (float)"};
+                  "Steps", "Risk Free Rate (float)", "Volatility (float)",
+                  "Parameterisation", "Target Accuracy (optional)"};
+
+              std::vector<std::vector<std::string>> mod_supp(
+                  mod_fields.size(), std::vector<std::string>());
+              mod_supp[3] = {"CRR", "JR", "Tian", "LR"};
 
-              Input m3i("Define Model Parameters", mod_fields);
+              Input m3i("Define Model Parameters", mod_fields, mod_supp);
 
               // preload existing model parameters
               if (model) {
                 m3i.responses = {std::to_string(model->steps),
                                  fvec_to_str(model->rates),
-                                 fvec_to_str(model->vols)};
+                                 fvec_to_str(model->vols),
+                                 param_str(model->param), ""};
               }
 
               std::vector<std::string> mod_input = m3i.show();
@@ -519,7 +610,7 @@ int main() {
               }
 
               if (mod_input[1] == "") {
-                float rfr = current_rfr();
+                float rfr = fetch([] { return current_rfr(); });
 
                 Info("Risk Free Rate",
                      std::format("Fetching risk free rate...\n\n"
@@ -535,7 +626,8 @@ int main() {
               if (mod_input[2] == "") {
                 if (option != nullptr) {
                   if (option->underlying != "") {
-                    float vol = current_vol(option->underlying);
+                    float vol =
+                        fetch([&] { return current_vol(option->underlying); });
 
                     Info("Volatility",
                          std::format("Fetching volatility...\n\n"
@@ -557,32 +649,62 @@ int main() {
                 }
               }
 
-              // clean all inputs, only 0-9, '.' and ',' allowed
-              for (int i = 0; i < mod_input.size(); i++) {
+              // clean all numeric inputs, only 0-9, '.' and ',' allowed
+              for (int i = 0; i <= 2; i++) {
                 mod_input[i] = numeric_filter(mod_input[i]);
               }
 
-              int s = std::stoi(mod_input[0]);
+              int s;
               std::vector<float> r = {}, v = {};
 
-              // splits input if it is comma seperated, or just instantiates the
-              // same value for each time step
-              std::string r_in = mod_input[1], v_in = mod_input[2], tmp;
-              if (r_in.find(',') != std::string::npos) {
-                std::stringstream ss(r_in);
-                while (std::getline(ss, tmp, ',')) {
-                  r.push_back(stof(tmp));
+              try {
+                s = std::stoi(mod_input[0]);
+                if (s < 1) {
+                  Info("Input Error", "'Steps' must be at least 1.").show();
+                  continue;
+                }
+
+                // steps are checked before the rate and vol vectors (or
+                // anything else proportional to them) are built, against the
+                // option if there is one and a binomial rollback otherwise
+                std::unique_ptr<Option> sized =
+                    std::make_unique<EuropeanOption>();
+                if (option) {
+                  sized = option->clone();
                 }
-              } else {
-                r.resize(s, std::stod(r_in));
-              }
-              if (v_in.find(',') != std::string::npos) {
-                std::stringstream ss(v_in);
-                while (std::getline(ss, tmp, ',')) {
-                  v.push_back(stof(tmp));
+                sized->model = Model();
+                sized->model.steps = s;
+                check(*sized);
+
+                // splits input if it is comma seperated, or just instantiates
+                // the same value for each time step
+                std::string r_in = mod_input[1], v_in = mod_input[2], tmp;
+                if (r_in.find(',') != std::string::npos) {
+                  std::stringstream ss(r_in);
+                  while (std::getline(ss, tmp, ',')) {
+                    r.push_back(stof(tmp));
+                  }
+                } else {
+                  r.resize(s, std::stod(r_in));
                 }
-              } else {
-                v.resize(s, std::stod(v_in));
+                if (v_in.find(',') != std::string::npos) {
+                  std::stringstream ss(v_in);
+                  while (std::getline(ss, tmp, ',')) {
+                    v.push_back(stof(tmp));
+                  }
+                } else {
+                  v.resize(s, std::stod(v_in));
+                }
+              } catch (const PlanError &e) {
+                Info("Model Error", e.what()).show();
+                continue;
+              } catch (const std::logic_error &) {
+                // std::stoi / std::stod on text that isn't a number, or out
+                // of range
+                Info("Input Error",
+                     "Steps, rates and volatilities must be numbers.")
+                    .show();
+                continue;
               }
 
               if (s != r.size() || s != v.size()) {
@@ -595,6 +717,46 @@ int main() {
 
               model = std::make_unique<Model>(Model(s, -1, r, v));
 
+              // parameterisation defaults to CRR if left empty
+              if (mod_input[3] != "") {
+                model->param = str_param(mod_input[3]);
+              }
+
+              // with a target accuracy the planner picks the engine and steps,
+              // otherwise the entered steps stand (checked above)
+              if (mod_input[4] != "" && !option) {
+                Info("Input Error", "Define the option before planning for a "
+                                    "target accuracy.")
+                    .show();
+                continue;
+              }
+
+              if (mod_input[4] != "") {
+                std::unique_ptr<Option> trial = option->clone();
+                trial->model = *model;
+                trial->model.dt = trial->expiration / model->steps;
+
+                try {
+                  Estimate e =
+                      plan(*trial, std::stod(numeric_filter(mod_input[4])));
+
+                  *model = model->resample(e.steps);
+                  model->dt = -1; // still a template, as entered
+                  if (!e.walk) {
+                    option->engine = e.engine;
+                  }
+
+                  Info("Pricing Plan", estimate_str(e)).show();
+                } catch (const PlanError &e) {
+                  Info("Model Error", e.what()).show();
+                  continue;
+                } catch (const std::logic_error &) {
+                  Info("Input Error", "'Target Accuracy' must be a number.")
+                      .show();
+                  continue;
+                }
+              }
+
               break;
             } else if (t3m == 1) /* load from json file */ {
               std::vector<std::string> files = list_dir("./models");
@@ -626,23 +788,109 @@ int main() {
             }
           }
         } else if (t2 == 2) /* run pricing */ {
-          // reinitialise model so branches are calculated properly
-          // and attach to the option object
-          option->model = Model(model->steps, option->expiration, model->rates,
-                                model->vols);
+          // attach a copy of the model to the option (keeping dividends and
+          // parameterisation) for its expiration, and refuse models too large
+          // to price
+          option->model = *model;
+          option->model.dt = option->expiration / model->steps;
+
+          try {
+            check(*option);
+          } catch (const PlanError &e) {
+            Info("Pricing Error", e.what()).show();
+            continue;
+          }
+          if (option->type == Type::Asian) {
+            // only the asian walk prices off the branches
+            option->model.update_branches();
+          }
 
-          float price = option->price();
+          // pricing runs in the background so large models can be
+          // watched converge, and stopped
+          std::vector<PricingTask::Result> refinements;
+          std::stop_source stop;
+          try {
+            refinements = price_in_background(*option, stop);
+          } catch (const std::exception &e) {
+            Info("Pricing Error", e.what()).show();
+            continue;
+          }
+          if (refinements.empty() || stop.stop_requested()) {
+            Info("Pricing Cancelled", "Pricing was cancelled before any "
+                                      "price was calculated.")
+                .show();
+            continue;
+          }
+          float price = refinements.back().price;
 
           Menu m3(
-              std::format("Option Price: {:.3f} {}", price, option->currency),
+              std::format("Option Price: {:.3f} {}{}", price, option->currency,
+                          refinements.back().steps < model->steps
+                              ? std::format(" ({} of {} steps)",
+                                            refinements.back().steps,
+                                            model->steps)
+                              : ""),
               {"View Pricing Report", "Save Option to File",
                "Save Model to File", "Show Binomial Model", "Show Delta Plot",
                "Show Theta Plot", "Back to Option Pricing"});
 
+          // the plots and the report's greeks are for the model that was
+          // priced, coarser than the one defined if pricing was stopped early
+          std::unique_ptr<Option> priced = option->clone();
+          if (refinements.back().steps != model->steps) {
+            priced->model = option->model.resample(refinements.back().steps);
+          }
+
+          // node values and greeks for the plots (downsampled to plot_budget
+          // nodes) and the exercise boundary are built in the background
+          // while the menu is up and shared by every plot and the report, the
+          // shaders read them back from a binary file named per process so
+          // two instances don't overwrite each other's, leaving the menu
+          // stops a build still running and removes the file
+          const std::filesystem::path plot_path =
+              std::filesystem::temp_directory_path() /
+              std::format("bopm-plot-{}.bin", getpid());
+          struct Plots {
+            PlotData data;
+            nlohmann::json meta;
+            std::optional<Boundary> boundary; // american options only
+          };
+          std::shared_future<Plots> plot_future =
+              std::async(std::launch::async,
+                         [&priced, &plot_path, token = stop.get_token()] {
+                           Plots p;
+                           p.data = plot_data(*priced, plot_budget, token);
+                           p.meta = write_plot_data(p.data, plot_path.string());
+                           if (priced->type == Type::American) {
+                             p.boundary = exercise_boundary(*priced, token);
+                           }
+                           return p;
+                         })
+                  .share();
+          // null, once the user has been told why, if the plot data or the
+          // boundary could not be built
+          auto plots = [&]() -> const Plots * {
+            try {
+              return &plot_future.get();
+            } catch (const Cancelled &) {
+              Info("Plots Cancelled",
+                   "Building the plot data was cancelled.")
+                  .show();
+            } catch (const std::exception &e) {
+              Info("Plot Error", e.what()).show();
+            }
+            return nullptr;
+          };
+
           while (true) {
             int t3 = m3.show();
 
             if (t3 == 0) /* display full pricing report */ {
+              const Plots *p = plots();
+              if (!p) {
+                continue;
+              }
+
               /* report structure:
               calculated option price
               option parameters
@@ -655,6 +903,15 @@ int main() {
                               "{:<26} : {:.3f}\n"
                               "\033[0m",
                               "Calculated Option Price", price);
+              for (PricingTask::Result &r : refinements) {
+                pricing_report += std::format(
+                    "{:<26} : {:.4f} ({:.1f} ms)\n",
+                    std::format("Price at {} Steps", r.steps), r.price, r.ms);
+              }
+              pricing_report += std::format(
+                  "{:<26} : {} hits, {} misses\n", "Lattice Cache",
+                  LatticeCache::global().hits(),
+                  LatticeCache::global().misses());
 
               std::string option_report = std::format(
                   "Option Parameters\n"
@@ -675,14 +932,17 @@ int main() {
                   "Model Parameters\n"
                   "\t{:<20} : {}\n"
                   "\t{:<20} : {}\n"
+                  "\t{:<20} : {}\n"
                   "\t{:<20} : {}\n",
                   "Steps", model->steps, "Rates", fvec_to_str(model->rates),
-                  "Volatilities", fvec_to_str(model->vols));
-
-              std::string delta_report =
-                  indent_linebreaks(print_tree(option->delta()), 29);
-              std::string theta_report =
-                  indent_linebreaks(print_tree(option->theta()), 29);
+                  "Volatilities", fvec_to_str(model->vols), "Parameterisation",
+                  param_str(model->param));
+
+              const PlotData &grid = p->data;
+              std::string delta_report = indent_linebreaks(
+                  print_tree(plot_rows(grid, grid.delta)), 29);
+              std::string theta_report = indent_linebreaks(
+                  print_tree(plot_rows(grid, grid.theta)), 29);
               // std::string vega_report =
               // indent_linebreaks(print_tree(option->vega()), 29);
 
@@ -693,9 +953,27 @@ int main() {
                   "\t{:<20} : {}\n",
                   "Delta", delta_report, "Theta", theta_report, "Vega", "[]");
 
+              // spot at which early exercise becomes optimal, at quarters
+              // of the option's life
+              if (p->boundary) {
+                const Boundary &b = *p->boundary;
+                greeks_report += std::format("\t{:<20} :", "Exercise Boundary");
+                for (float f : {0.f, 0.25f, 0.5f, 0.75f, 1.f}) {
+                  greeks_report += std::format(" [{:.2f}y {:.3f}]",
+                                               f * b.time.back(),
+                                               b.at(f * b.time.back()));
+                }
+                greeks_report += "\n";
+              }
+
+              // time, nodes and allocations for everything priced this
+              // session
+              std::string instrument_report = instrument::report();
+
               Info i3("Option Pricing Report",
                       pricing_report + "\n" + option_report + "\n" +
-                          model_report + "\n" + greeks_report);
+                          model_report + "\n" + greeks_report + "\n" +
+                          instrument_report);
               i3.show();
 
             } else if (t3 == 1) /* save option to file */ {
@@ -726,107 +1004,27 @@ int main() {
                          model->to_json().dump(2));
 
             } else if (t3 == 3) /* show binomial model */ {
-              std::vector<std::vector<float>> factor_tree;
-              factor_tree.resize(option->model.steps);
-
-              for (int i = 0; i < option->model.steps; i++) {
-                for (int ii = 0; ii < option->model.branches[i].size(); ii++) {
-                  factor_tree[i].push_back(option->model.branches[i][i].uFac);
-                  factor_tree[i].push_back(option->model.branches[i][i].dFac);
-                }
-              }
-
-              std::vector<std::vector<float>> value_tree = {{option->spot}};
-              std::vector<float> tmp;
-
-              for (int i = 0; i < option->model.steps; i++) {
-                tmp = {};
-
-                for (int ii = 0; ii < option->model.branches[i].size(); ii++) {
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].uFac);
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].dFac);
-                }
-
-                value_tree.push_back(tmp);
+              if (const Plots *p = plots()) {
+                Plot(read_file("./shaders/model-tree.py"), p->meta.dump())
+                    .run();
               }
 
-              nlohmann::json data;
-              data["strike"] = option->strike;
-              data["v"] = value_tree;
-
-              Plot(read_file("./shaders/model-tree.py"), data.dump()).run();
-
             } else if (t3 == 4) /* show delta plot */ {
-              std::vector<std::vector<float>> delta_tree = option->delta();
-              std::vector<std::vector<float>> value_tree = {{option->spot}};
-              std::vector<float> tmp;
-
-              for (int i = 0; i < option->model.steps; i++) {
-                tmp = {};
-
-                for (int ii = 0; ii < option->model.branches[i].size(); ii++) {
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].uFac);
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].dFac);
-                }
-
-                value_tree.push_back(tmp);
+              if (const Plots *p = plots()) {
+                Plot(read_file("./shaders/delta.py"), p->meta.dump()).run();
               }
 
-              // print_tree(delta_tree);
-
-              nlohmann::json data;
-              data["delta_tree"] = delta_tree;
-              data["value_tree"] = value_tree;
-
-              Plot(read_file("./shaders/delta.py"), data.dump()).run();
-
             } else if (t3 == 5) /* show theta plot */ {
-              std::vector<std::vector<float>> theta_tree = option->theta();
-              std::vector<std::vector<float>> value_tree = {{option->spot}};
-              std::vector<float> tmp;
-
-              for (int i = 0; i < option->model.steps; i++) {
-                tmp = {};
-
-                for (int ii = 0; ii < option->model.branches[i].size(); ii++) {
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].uFac);
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].dFac);
-                }
-
-                value_tree.push_back(tmp);
+              if (const Plots *p = plots()) {
+                Plot(read_file("./shaders/theta.py"), p->meta.dump()).run();
               }
 
-              nlohmann::json data;
-              data["theta_tree"] = theta_tree;
-              data["value_tree"] = value_tree;
-
-              Plot(read_file("./shaders/theta.py"), data.dump()).run();
-
             } else if (t3 == -1) /* show vega plot */ {
               continue;
               std::vector<std::vector<float>> vega_tree = option->vega();
 
-              std::vector<std::vector<float>> value_tree = {{option->spot}};
-              std::vector<float> tmp;
-
-              for (int i = 0; i < option->model.steps; i++) {
-                tmp = {};
-
-                for (int ii = 0; ii < option->model.branches[i].size(); ii++) {
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].uFac);
-                  tmp.push_back(value_tree.back()[ii] *
-                                option->model.branches[i][ii].dFac);
-                }
-
-                value_tree.push_back(tmp);
-              }
+              std::vector<std::vector<float>> value_tree =
+                  option->model.value_tree(option->spot);
 
               nlohmann::json data;
               data["vega_tree"] = vega_tree;
@@ -835,6 +1033,10 @@ int main() {
               Plot(read_file("./shaders/vega.py"), data.dump()).run();
 
             } else if (t3 == 6) /* back to option pricing */ {
+              stop.request_stop(); // the plot data may still be building
+              plot_future.wait();
+              std::error_code ec; // nothing to remove if it was never written
+              std::filesystem::remove(plot_path, ec);
               break;
             }
           }
@@ -1,7 +1,37 @@
 #include "model.hpp"
+#include "instrument.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <iostream>
 
+std::string precision_str(Precision p) {
+  if (p == Precision::Float) {
+    return "Float";
+
+  } else if (p == Precision::Double) {
+    return "Double";
+
+  } else if (p == Precision::Undefined) {
+    return "-";
+
+  } else {
+    return "?";
+  }
+}
+
+Precision str_precision(std::string s) {
+  if (s == "Float") {
+    return Precision::Float;
+
+  } else if (s == "Double") {
+    return Precision::Double;
+
+  } else {
+    return Precision::Undefined;
+  }
+}
+
 Model::Model() {}
 
 Model::Model(int s, float e, float r, float v) {
@@ -17,8 +47,6 @@ Model::Model(int s, float e, float r, float v) {
     dt = -1;
   } else {
     dt = e / steps;
-
-    update_branches();
   }
 }
 
@@ -35,8 +63,6 @@ Model::Model(int s, float e, std::vector<float> r, std::vector<float> v) {
     dt = -1;
   } else {
     dt = e / steps;
-
-    update_branches();
   }
 }
 
@@ -60,33 +86,130 @@ Model::Model(int s, float e, std::vector<float> r, std::vector<float> v,
 }
 
 nlohmann::json Model::to_json() {
+  BOPM_TIME(Phase::Serialise);
+
   nlohmann::json data;
   data["steps"] = steps;
   data["dt"] = dt;
   data["rates"] = rates;
   data["volatilities"] = vols;
+  data["yield"] = yield;
+  data["parameterisation"] = param_str(param);
+  data["prune"] = prune;
+  data["precision"] = precision_str(precision);
+  data["control_variate"] = control;
+
+  data["dividends"] = nlohmann::json::array();
+  for (Dividend &div : dividends) {
+    data["dividends"].push_back({{"time", div.time},
+                                 {"amount", div.amount},
+                                 {"type", div.type == DividendType::Cash
+                                              ? "Cash"
+                                              : "Proportional"}});
+  }
+
   return data;
 }
 
 void Model::from_json(nlohmann::json data) {
+  BOPM_TIME(Phase::Parse);
+
   steps = data["steps"];
-  dt = data["dt"];
+  // dt is optional, a model priced against an option takes it from the expiration (-1 marks a template)
+  dt = data.value("dt", -1.f);
   rates = data["rates"].get<std::vector<float>>();
   vols = data["volatilities"].get<std::vector<float>>();
 
-  update_branches();
+  // dividend fields are optional, older model files do not contain them
+  yield = data.value("yield", 0.f);
+  param = str_param(data.value("parameterisation", "CRR"));
+  prune = data.value("prune", 0.f);
+  precision = str_precision(data.value("precision", "Double"));
+  control = data.value("control_variate", false);
+
+  dividends = {};
+  if (data.contains("dividends")) {
+    for (nlohmann::json &div : data["dividends"]) {
+      dividends.push_back(Dividend(div["time"], div["amount"],
+                                   div["type"] == "Cash"
+                                       ? DividendType::Cash
+                                       : DividendType::Proportional));
+    }
+  }
+
+  branches = {};
 }
 
 void Model::update_branches() {
+  BOPM_TIME(Phase::Setup);
+
   float u, d, p;
 
   branches.resize(steps);
   for (int i = 0; i < branches.size(); i++) {
-    u = std::pow(std::numbers::e, vols[i] * std::sqrt(dt));
-    d = 1 / u;
+    // factors from the selected parameterisation, there is no strike attached
+    // to the model so LR is centred at the money
+    if (param == Param::JR) {
+      JR::factors(rates[i], yield, vols[i], dt, steps, 0.f, u, d);
+    } else if (param == Param::Tian) {
+      Tian::factors(rates[i], yield, vols[i], dt, steps, 0.f, u, d);
+    } else if (param == Param::LR) {
+      LR::factors(rates[i], yield, vols[i], dt, steps, 0.f, u, d);
+    } else /* CRR */ {
+      CRR::factors(rates[i], yield, vols[i], dt, steps, 0.f, u, d);
+    }
+
+    p = (std::pow(std::numbers::e, (rates[i] - yield) * dt) - d) / (u - d);
+
+    // tree recombines (an up then down move lands on the same node as down
+    // then up), so step i only has i + 1 nodes
+    branches[i].assign(i + 1, Branch(p, u, 1 - p, d));
+  }
+}
 
-    p = (std::pow(std::numbers::e, rates[i] * dt) - d) / (u - d);
+Model Model::resample(int s) const {
+  Model m = *this;
+  m.steps = s;
+  m.dt = dt * steps / s;
+  m.rates.assign(s, 0);
+  m.vols.assign(s, 0);
+  m.branches = {};
+
+  // each new step takes the mean rate and rms vol of the old steps it overlaps, weighted by the overlap (in
+  // units of 1 / (steps * s) of the model's span, so the bounds stay integers)
+  for (int i = 0; i < s; i++) {
+    long lo = (long)i * steps, hi = (long)(i + 1) * steps;
+    double rate = 0, var = 0;
+
+    for (long k = lo / s; k < steps && k * s < hi; k++) {
+      long w = std::min(hi, (k + 1) * s) - std::max(lo, k * s);
+      rate += (double)w * rates[k];
+      var += (double)w * vols[k] * vols[k];
+    }
+
+    m.rates[i] = rate / steps;
+    m.vols[i] = std::sqrt(var / steps);
+  }
+
+  return m;
+}
+
+std::vector<std::vector<float>> Model::value_tree(float spot) const {
+  std::vector<std::vector<float>> tree = {{spot}};
+  tree.reserve(steps + 1);
 
-    branches[i].resize(std::pow(2, i), Branch(p, u, 1 - p, d));
+  for (int i = 0; i < steps; i++) {
+    // branches recombine, node ii moves down to ii and up to ii + 1
+    std::vector<float> row;
+    row.reserve(branches[i].size() + 1);
+    row.push_back(tree.back()[0] * branches[i][0].dFac);
+
+    for (int ii = 0; ii < branches[i].size(); ii++) {
+      row.push_back(tree.back()[ii] * branches[i][ii].uFac);
+    }
+
+    tree.push_back(std::move(row));
   }
+
+  return tree;
 }
@@ -1,3 +1,91 @@
+#include "arena.hpp"
+#include "lattice.hpp"
 #include "options.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 
 AsianOption::AsianOption() : Option(Type::Asian) {}
+
+float AsianOption::payout(std::vector<float> intervals) {
+  float avg = std::accumulate(intervals.begin(), intervals.end(), 0.f) / intervals.size();
+
+  // fixed strike options pay against the strike, floating strike options pay against the final spot
+  float s = payoff_type == PayoffType::Fixed ? avg : intervals.back();
+  float k = payoff_type == PayoffType::Fixed ? strike : avg;
+
+  if (side == Side::Call) {
+    return std::max(s - k, 0.f);
+  } else /* Put */ {
+    return std::max(k - s, 0.f);
+  }
+}
+
+float AsianOption::price(Engine) {
+  // models don't build their branches, build them here if the caller hasn't
+  if (model.branches.size() != model.steps) {
+    model.update_branches();
+  }
+
+  // discrete dividends as the lattice applies them: the walk moves the spot less escrowed cash dividends, and
+  // each observation is that scaled by the proportional dividends gone ex plus the cash still to be paid
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+  std::pmr::vector<double> scale(&arena), escrow(&arena);
+  dividend_adjustments(model, scale, escrow);
+
+  std::vector<float> x{float(spot - escrow[0])}, path{spot};
+  float total = 0;
+
+  // depth first walk of every path through the branches, weighting each payout by the path probability
+  // (branches recombine but payouts depend on the path taken, so this is still 2^steps paths)
+  //
+  // a stop is polled before each subtree below depth top, each worth an equal share of the model's steps in
+  // progress, so a pricing task can cancel a deep walk within one subtree (2^(steps - top) paths)
+  int top = std::min(model.steps, 12);
+  long subtree = 0;
+
+  auto walk = [&](auto &self, int i, int node, float prob, float df) -> void {
+    if (i == top) {
+      Progress::step(((subtree + 1) * model.steps >> top) - (subtree * model.steps >> top));
+      subtree++;
+    }
+
+    if (i == model.steps) {
+      total += prob * df * payout(path);
+      return;
+    }
+
+    const Branch &b = model.branches[i][node];
+    float step_df = df * std::exp(-model.rates[i] * model.dt);
+
+    float s = scale[i + 1], e = escrow[i + 1];
+
+    x.push_back(x[i] * b.uFac);
+    path.push_back(x.back() * s + e);
+    self(self, i + 1, node + 1, prob * b.uProb, step_df);
+    x.back() = x[i] * b.dFac;
+    path.back() = x.back() * s + e;
+    self(self, i + 1, node, prob * b.dProb, step_df);
+    x.pop_back();
+    path.pop_back();
+  };
+  walk(walk, 0, 0, 1, 1);
+
+  return total;
+}
+
+std::unique_ptr<Option> AsianOption::clone() const { return std::make_unique<AsianOption>(*this); }
+
+nlohmann::json AsianOption::to_json() {
+  nlohmann::json data = Option::to_json();
+  data["payoff_type"] = payoff_type_str(payoff_type);
+
+  return data;
+}
+
+void AsianOption::from_json(nlohmann::json data) {
+  Option::from_json(data);
+  payoff_type = str_payoff_type(data["payoff_type"]);
+}
@@ -1,4 +1,11 @@
+#include "arena.hpp"
+#include "blackscholes.hpp"
+#include "cache.hpp"
+#include "fdm.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
 #include "options.hpp"
+#include "trinomial.hpp"
 #include <cmath>
 #include <iostream>
 
@@ -50,15 +57,193 @@ std::string payoff_type_str(PayoffType pt) {
   }
 }
 
+std::string engine_str(Engine e) {
+  if (e == Engine::Binomial) {
+    return "Binomial";
+
+  } else if (e == Engine::Trinomial) {
+    return "Trinomial";
+
+  } else if (e == Engine::FiniteDifference) {
+    return "Finite Difference";
+
+  } else if (e == Engine::Undefined) {
+    return "-";
+
+  } else {
+    return "?";
+  }
+}
+
+std::string rainbow_payoff_str(RainbowPayoff p) {
+  if (p == RainbowPayoff::Spread) {
+    return "Spread";
+
+  } else if (p == RainbowPayoff::Basket) {
+    return "Basket";
+
+  } else if (p == RainbowPayoff::BestOf) {
+    return "Best Of";
+
+  } else if (p == RainbowPayoff::WorstOf) {
+    return "Worst Of";
+
+  } else if (p == RainbowPayoff::Undefined) {
+    return "-";
+
+  } else {
+    return "?";
+  }
+}
+
+Type str_type(std::string s) {
+  if (s == "European") {
+    return Type::European;
+
+  } else if (s == "American") {
+    return Type::American;
+
+  } else if (s == "Asian") {
+    return Type::Asian;
+
+  } else {
+    return Type::Undefined;
+  }
+}
+
+Side str_side(std::string s) {
+  if (s == "Call") {
+    return Side::Call;
+
+  } else if (s == "Put") {
+    return Side::Put;
+
+  } else {
+    return Side::Undefined;
+  }
+}
+
+PayoffType str_payoff_type(std::string s) {
+  if (s == "Fixed") {
+    return PayoffType::Fixed;
+
+  } else if (s == "Floating") {
+    return PayoffType::Floating;
+
+  } else {
+    return PayoffType::Undefined;
+  }
+}
+
+Engine str_engine(std::string s) {
+  if (s == "Binomial") {
+    return Engine::Binomial;
+
+  } else if (s == "Trinomial") {
+    return Engine::Trinomial;
+
+  } else if (s == "Finite Difference") {
+    return Engine::FiniteDifference;
+
+  } else {
+    return Engine::Undefined;
+  }
+}
+
+RainbowPayoff str_rainbow_payoff(std::string s) {
+  if (s == "Spread") {
+    return RainbowPayoff::Spread;
+
+  } else if (s == "Basket") {
+    return RainbowPayoff::Basket;
+
+  } else if (s == "Best Of") {
+    return RainbowPayoff::BestOf;
+
+  } else if (s == "Worst Of") {
+    return RainbowPayoff::WorstOf;
+
+  } else {
+    return RainbowPayoff::Undefined;
+  }
+}
+
 Option::Option()
-    : underlying(""), currency(""), spot(std::nanf(0)), strike(std::nanf(0)), expiration(std::nanf(0)), type(Type::Undefined), side(Side::Undefined) {}
+    : underlying(""), currency(""), spot(std::nanf("")), strike(std::nanf("")), expiration(std::nanf("")), type(Type::Undefined), side(Side::Undefined),
+      engine(Engine::Binomial) {}
 
-Option::Option(Type t) : underlying(""), currency(""), spot(std::nanf(0)), strike(std::nanf(0)), expiration(std::nanf(0)), type(t), side(Side::Undefined) {}
+Option::Option(Type t)
+    : underlying(""), currency(""), spot(std::nanf("")), strike(std::nanf("")), expiration(std::nanf("")), type(t), side(Side::Undefined),
+      engine(Engine::Binomial) {}
 
-float Option::payout(float spot) {
+float Option::payout(float spot) const {
   if (side == Side::Call) {
     return std::max(spot - strike, 0.f);
   } else /* Put */ {
     return std::max(strike - spot, 0.f);
   }
 }
+
+float Option::price() { return price(engine); }
+
+std::unique_ptr<Option> Option::clone() const { return std::make_unique<Option>(*this); }
+
+float Option::price(Engine e) {
+  // engine buffers live in the thread's arena and are released together when the scope closes
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  if (e == Engine::Trinomial) {
+    return rollback(*this, Trinomial(model, &arena));
+  } else if (e == Engine::FiniteDifference) {
+    return solve(*this, FiniteDifference(model, spot, 0, &arena)).price;
+  } else /* Binomial */ {
+    // lattice setup is shared through the cache, repricing at a new spot only rolls back
+    LatticeCache &cache = LatticeCache::global();
+
+    if (model.control && type == Type::American) {
+      double european = black_scholes(*this, model);
+      if (model.precision == Precision::Double) {
+        return rollback_cv(*this, *cache.get<double>(model, spot, strike), european);
+      } else /* Float */ {
+        return rollback_cv(*this, *cache.get<float>(model, spot, strike), european);
+      }
+    }
+
+    if (model.precision == Precision::Double) {
+      return rollback(*this, *cache.get<double>(model, spot, strike));
+    } else /* Float */ {
+      return rollback(*this, *cache.get<float>(model, spot, strike));
+    }
+  }
+}
+
+nlohmann::json Option::to_json() {
+  BOPM_TIME(Phase::Serialise);
+
+  nlohmann::json data;
+  data["underlying"] = underlying;
+  data["currency"] = currency;
+  data["spot"] = spot;
+  data["strike"] = strike;
+  data["expiration"] = expiration;
+  data["type"] = type_str(type);
+  data["side"] = side_str(side);
+  data["engine"] = engine_str(engine);
+
+  return data;
+}
+
+void Option::from_json(nlohmann::json data) {
+  BOPM_TIME(Phase::Parse);
+
+  underlying = data.value("underlying", "");
+  currency = data.value("currency", "");
+  spot = data["spot"];
+  strike = data["strike"];
+  expiration = data["expiration"];
+  side = str_side(data["side"]);
+
+  // engine is optional, older option files do not contain it
+  engine = str_engine(data.value("engine", "Binomial"));
+}
@@ -0,0 +1,74 @@
+#include "arena.hpp"
+#include "instrument.hpp"
+#include "lattice2d.hpp"
+#include "options.hpp"
+#include <cmath>
+#include <stdexcept>
+
+RainbowOption::RainbowOption()
+    : underlying{"", ""}, currency(""), spot{std::nanf(""), std::nanf("")}, weight{1, 1}, strike(std::nanf("")), expiration(std::nanf("")),
+      type(Type::Undefined), side(Side::Undefined), payoff(RainbowPayoff::Undefined), correlation(0) {}
+
+float RainbowOption::payout(float s1, float s2) const {
+  float x;
+  if (payoff == RainbowPayoff::Spread) {
+    x = weight[0] * s1 - weight[1] * s2;
+  } else if (payoff == RainbowPayoff::Basket) {
+    x = weight[0] * s1 + weight[1] * s2;
+  } else if (payoff == RainbowPayoff::BestOf) {
+    x = std::max(s1, s2);
+  } else /* WorstOf */ {
+    x = std::min(s1, s2);
+  }
+
+  if (side == Side::Call) {
+    return std::max(x - strike, 0.f);
+  } else /* Put */ {
+    return std::max(strike - x, 0.f);
+  }
+}
+
+float RainbowOption::price(int threads) {
+  if (type != Type::European && type != Type::American) {
+    throw std::invalid_argument("rainbow options must be european or american");
+  }
+
+  // both slices of the lattice live in the thread's arena
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  return rollback(*this, Lattice2D(*this, &arena), threads);
+}
+
+nlohmann::json RainbowOption::to_json() {
+  BOPM_TIME(Phase::Serialise);
+
+  nlohmann::json data;
+  data["underlying"] = underlying;
+  data["currency"] = currency;
+  data["spot"] = spot;
+  data["weight"] = weight;
+  data["strike"] = strike;
+  data["expiration"] = expiration;
+  data["type"] = type_str(type);
+  data["side"] = side_str(side);
+  data["payoff"] = rainbow_payoff_str(payoff);
+  data["correlation"] = correlation;
+
+  return data;
+}
+
+void RainbowOption::from_json(nlohmann::json data) {
+  BOPM_TIME(Phase::Parse);
+
+  underlying = data.value("underlying", std::array<std::string, 2>{"", ""});
+  currency = data.value("currency", "");
+  spot = data["spot"];
+  weight = data.value("weight", std::array<float, 2>{1, 1});
+  strike = data["strike"];
+  expiration = data["expiration"];
+  type = str_type(data["type"]);
+  side = str_side(data["side"]);
+  payoff = str_rainbow_payoff(data["payoff"]);
+  correlation = data["correlation"];
+}
@@ -0,0 +1,40 @@
+#include "params.hpp"
+
+std::string param_str(Param p) {
+  if (p == Param::CRR) {
+    return "CRR";
+
+  } else if (p == Param::JR) {
+    return "JR";
+
+  } else if (p == Param::Tian) {
+    return "Tian";
+
+  } else if (p == Param::LR) {
+    return "LR";
+
+  } else if (p == Param::Undefined) {
+    return "-";
+
+  } else {
+    return "?";
+  }
+}
+
+Param str_param(std::string s) {
+  if (s == "CRR") {
+    return Param::CRR;
+
+  } else if (s == "JR") {
+    return Param::JR;
+
+  } else if (s == "Tian") {
+    return Param::Tian;
+
+  } else if (s == "LR") {
+    return Param::LR;
+
+  } else {
+    return Param::Undefined;
+  }
+}
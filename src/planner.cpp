@@ -0,0 +1,256 @@
+#include "planner.hpp"
+#include "cache.hpp"
+#include "fdm.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "trinomial.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+std::string bytes_str(double b) {
+  if (b >= 1e9) {
+    return std::format("{:.1f} GB", b / 1e9);
+  } else if (b >= 1e6) {
+    return std::format("{:.1f} MB", b / 1e6);
+  } else {
+    return std::format("{:.1f} KB", b / 1e3);
+  }
+}
+
+std::string ms_str(double ms) {
+  if (ms >= 3.6e6) {
+    return std::format("{:.3g} h", ms / 3.6e6);
+  } else if (ms >= 1e3) {
+    return std::format("{:.1f} s", ms / 1e3);
+  } else {
+    return std::format("{:.3g} ms", ms);
+  }
+}
+
+// fastest of a few runs, the first is usually slowed by page faults
+template <typename F> double ns(F f) {
+  double best = std::numeric_limits<double>::infinity();
+  for (int rep = 0; rep < 3; rep++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+Model flat(int steps) {
+  Model m(steps, -1, 0.05f, 0.2f);
+  m.dt = 1.f / steps;
+  return m;
+}
+
+// error(n) ~ c / n^order of the engine on this option, from its prices at 128, 256 and 512 steps
+//
+// the order is fitted from the ratio of successive differences but kept between 1 and the engine's nominal
+// order (1 for the lattices, whose prices oscillate too much to fit, 2 for crank-nicolson, which early exercise
+// pulls towards 1.5), c then takes the larger of the two differences
+struct Convergence {
+  double c, order;
+  double error(double steps) const { return c / std::pow(steps, order); }
+  double steps(double error) const { return std::pow(c / error, 1 / order); }
+};
+
+Convergence convergence(const Option &o, Engine e) {
+  instrument::Pause pause;     // planning, not pricing
+  LatticeCache::Bypass bypass; // nor lattices the user will reprice
+
+  std::unique_ptr<Option> c = o.clone();
+
+  double price[3];
+  for (int k = 0; k < 3; k++) {
+    c->model = o.model.resample(128 << k);
+    price[k] = c->price(e);
+  }
+
+  double d0 = std::abs(price[0] - price[1]), d1 = std::abs(price[1] - price[2]);
+  double nominal = e == Engine::FiniteDifference ? 2 : 1;
+  double p = d0 > 0 && d1 > 0 ? std::clamp(std::log2(d0 / d1), 1.0, nominal) : nominal;
+
+  double f = 1 - std::pow(2.0, -p);
+  return {std::max(d0 * std::pow(128.0, p), d1 * std::pow(256.0, p)) / f, p};
+}
+
+// nodes, memory and time, without the error
+Estimate cost(const Option &o, Engine e, int steps) {
+  const Calibration &cal = calibration();
+  double n = steps;
+
+  bool walk = o.type == Type::Asian;
+  Estimate est{walk ? Engine::Undefined : e, walk, steps, 0, 0, 0, std::nan("")};
+
+  if (walk) {
+    // every path is walked (2^(steps + 1) visits), over branches holding every node of the tree, time and so
+    // the refusal in check() go with the 2^steps paths rather than any lattice size
+    est.nodes = std::pow(2.0, n + 1);
+    est.bytes = 16 * (n + 1) * (n + 2) / 2 + 24 * n + 4 * n;
+    est.ms = est.nodes * cal.asian / 1e6;
+
+  } else if (e == Engine::Trinomial) {
+    est.nodes = (n + 1) * (n + 1);
+    est.bytes = 4 * (4 * n + 2 * (n + 1) + 2 * (2 * n + 1));
+    est.ms = est.nodes * cal.trinomial / 1e6;
+
+  } else if (e == Engine::FiniteDifference) {
+    double nodes = std::max(steps, 101) | 1;
+    est.nodes = nodes * (n + 1);
+    est.bytes = 4 * (2 * n + 2 * (n + 1)) + 8 * 6 * nodes;
+    est.ms = est.nodes * cal.fdm / 1e6;
+
+  } else /* Binomial */ {
+    // pruned lattices keep about prune * sqrt(i) + 3 nodes at step i (the band and a node either side)
+    const Model &m = o.model;
+    est.nodes = (n + 1) * (n + 2) / 2;
+    if (m.prune > 0) {
+      est.nodes = std::min(est.nodes, 2 * m.prune * std::pow(n, 1.5) / 3 + 3 * n);
+    }
+
+    bool single = m.precision == Precision::Float;
+    double t = single ? 4 : 8;
+    est.bytes = t * (2 * n + 2 * (n + 1)) + 4 * 2 * (n + 1) + t * (2 * n + 1) + t * (n + 1) * (m.control ? 2 : 1);
+    est.ms = est.nodes * (single ? cal.binomial_float : cal.binomial_double) * (m.control && o.type == Type::American ? 1.4 : 1) / 1e6;
+  }
+
+  return est;
+}
+
+bool within(const Estimate &e, const Limits &limits) { return e.bytes <= limits.bytes && e.ms <= limits.ms; }
+
+// log of the highest spot a float lattice would roll back, against the largest float (calls price inf past it),
+// from the rms vol over the nodes kept (every up move, or the band pruning keeps), the model's drift is left to
+// the margin, a model with no vols yet (sized before they are built) is not checked
+bool float_overflows(const Option &o) {
+  const Model &m = o.model;
+  if (o.engine != Engine::Binomial || m.precision != Precision::Float || m.vols.size() < m.steps || !(m.dt > 0)) {
+    return false;
+  }
+
+  double var = 0;
+  for (int i = 0; i < m.steps; i++) {
+    var += m.vols[i] * m.vols[i];
+  }
+  double sd = std::sqrt(var * m.dt); // of log spot over the model's life
+  double reach = sd * std::sqrt(m.steps); // every step up
+  if (m.prune > 0) {
+    reach = std::min(reach, (m.prune + 1) * sd);
+  }
+
+  return std::log(o.spot) + reach > std::log(std::numeric_limits<float>::max()) - 2;
+}
+
+} // namespace
+
+std::string estimate_str(const Estimate &e) {
+  std::string str = e.walk ? std::format("Asian path walk, {} steps: 2^{} paths ({:.3g} node visits), {}, ~{}", e.steps, e.steps, e.nodes,
+                                         bytes_str(e.bytes), ms_str(e.ms))
+                           : std::format("{}, {} steps: {:.3g} nodes, {}, ~{}", engine_str(e.engine), e.steps, e.nodes, bytes_str(e.bytes), ms_str(e.ms));
+  if (!std::isnan(e.error)) {
+    str += std::format(", error ~{:.2g}", e.error);
+  }
+  return str;
+}
+
+double Limits::default_bytes() { return (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE) / 2; }
+
+const Calibration &calibration() {
+  static const Calibration cal = [] {
+    instrument::Pause pause; // calibration runs are not the user's, keep them out of the counters
+
+    AmericanOption o;
+    o.spot = 100;
+    o.strike = 100;
+    o.expiration = 1;
+    o.side = Side::Put;
+
+    Calibration c;
+
+    o.model = flat(3000);
+    double nodes = 3001.0 * 3002 / 2;
+    BasicLattice<float> lf(o.model, o.spot, o.strike);
+    BasicLattice<double> ld(o.model, o.spot, o.strike);
+    c.binomial_float = ns([&] { rollback(o, lf); }) / nodes;
+    c.binomial_double = ns([&] { rollback(o, ld); }) / nodes;
+
+    o.model = flat(1500);
+    Trinomial t(o.model);
+    c.trinomial = ns([&] { rollback(o, t); }) / (1501.0 * 1501);
+
+    o.model = flat(1000);
+    FiniteDifference fd(o.model, o.spot);
+    c.fdm = ns([&] { solve(o, fd); }) / ((double)fd.nodes * 1001);
+
+    AsianOption a;
+    a.spot = 100;
+    a.strike = 100;
+    a.expiration = 1;
+    a.side = Side::Call;
+    a.payoff_type = PayoffType::Fixed;
+    a.model = Model(14, 1, 0.05f, 0.2f);
+    c.asian = ns([&] { a.price(); }) / std::pow(2.0, 15);
+
+    return c;
+  }();
+
+  return cal;
+}
+
+Estimate estimate(const Option &o, Engine e, int steps) {
+  Estimate est = cost(o, e, steps);
+  if (o.type != Type::Asian) {
+    est.error = convergence(o, e).error(steps);
+  }
+  return est;
+}
+
+Estimate plan(const Option &o, double accuracy, const Limits &limits) {
+  if (o.type == Type::Asian) {
+    check(o, limits);
+    return cost(o, o.engine, o.model.steps);
+  }
+
+  std::vector<Estimate> candidates;
+  for (Engine e : {Engine::Binomial, Engine::Trinomial, Engine::FiniteDifference}) {
+    // steps for the error to come down to half the accuracy (lattice errors oscillate about the fitted curve
+    // by about that much), capped well beyond anything that fits the limits
+    Convergence conv = convergence(o, e);
+    double steps = std::clamp(std::ceil(conv.steps(accuracy / 2)), 16.0, 1e9);
+
+    Estimate est = cost(o, e, steps);
+    est.error = conv.error(steps);
+    candidates.push_back(est);
+  }
+
+  auto faster = [](const Estimate &a, const Estimate &b) { return a.ms < b.ms; };
+  std::sort(candidates.begin(), candidates.end(), faster);
+
+  for (Estimate &e : candidates) {
+    if (within(e, limits)) {
+      return e;
+    }
+  }
+
+  throw PlanError(std::format("no engine prices this option to within {:.2g} in {} and {}, the cheapest needs\n{}", accuracy, bytes_str(limits.bytes),
+                              ms_str(limits.ms), estimate_str(candidates.front())));
+}
+
+void check(const Option &o, const Limits &limits) {
+  Estimate e = cost(o, o.engine, o.model.steps);
+
+  if (!within(e, limits)) {
+    throw PlanError(std::format("pricing this option would take more than {} or {}:\n{}", bytes_str(limits.bytes), ms_str(limits.ms), estimate_str(e)));
+  }
+  if (float_overflows(o)) {
+    throw PlanError("the lattice's highest spots would overflow a float at these steps and vols, price in Double precision (or prune)");
+  }
+}
@@ -0,0 +1,171 @@
+#include "plotdata.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace {
+
+// count evenly spaced indices in [0, n], always including both ends
+std::vector<int> spaced(int n, int count) {
+  std::vector<int> idx;
+  if (count >= n + 1) {
+    for (int k = 0; k <= n; k++) {
+      idx.push_back(k);
+    }
+  } else {
+    for (int k = 0; k < count; k++) {
+      idx.push_back(std::lround((double)k * n / (count - 1)));
+    }
+  }
+  return idx;
+}
+
+// nodes either side of a kept node one step on, and the three nearest its spot two steps on, copied out of the
+// rollback so its greeks can be worked out afterwards (nan where the step is past expiry or the spot is outside it)
+struct Stencil {
+  double spot, value;
+  double next_spot[2], next_value[2], later_spot[3], later_value[3];
+};
+
+// copy the three nodes nearest spot s on a step into out, the middle one the first node at or below s (clamped
+// in from the ends), node j two steps on only has node j's spot when u * d = 1 (as in CRR)
+void nearest(double s, const std::vector<double> &spots, const std::vector<double> &values, int step, double *out_spot, double *out_value) {
+  if (!(s >= spots[0] && s <= spots[step])) {
+    std::fill(out_spot, out_spot + 3, std::nan(""));
+    std::fill(out_value, out_value + 3, std::nan(""));
+    return;
+  }
+
+  int k = std::upper_bound(spots.begin(), spots.begin() + step + 1, s) - spots.begin();
+  k = std::clamp(k - 1, 1, step - 1);
+  std::copy(spots.begin() + k - 1, spots.begin() + k + 2, out_spot);
+  std::copy(values.begin() + k - 1, values.begin() + k + 2, out_value);
+}
+
+// value at spot s, quadratic in log spot through three nodes (a straight line would leave a convexity error of
+// the order of dt, as large as theta itself)
+double value_at(double s, const double *spots, const double *values) {
+  double x = std::log(s), x0 = std::log(spots[0]), x1 = std::log(spots[1]), x2 = std::log(spots[2]);
+  return values[0] * (x - x1) * (x - x2) / ((x0 - x1) * (x0 - x2)) + values[1] * (x - x0) * (x - x2) / ((x1 - x0) * (x1 - x2)) +
+         values[2] * (x - x0) * (x - x1) / ((x2 - x0) * (x2 - x1));
+}
+
+template <typename T> void write(std::ofstream &out, const std::vector<T> &v) { out.write((const char *)v.data(), v.size() * sizeof(T)); }
+
+} // namespace
+
+PlotData plot_data(const Option &o, size_t budget, std::stop_token stop) {
+  // plots show every node, so the lattice is built unpruned (the constructor times itself as setup)
+  Model m = o.model;
+  m.prune = 0;
+  BasicLattice<double> l(m, o.spot, o.strike);
+
+  int n = l.steps;
+  int side = std::max<int>(2, std::sqrt(budget));
+  bool path = o.type == Type::Asian;
+  double nan = std::nan("");
+
+  PlotData d;
+  d.steps = n;
+  d.strike = o.strike;
+
+  std::vector<bool> keep(n + 1);
+  for (int i : spaced(n, side)) {
+    keep[i] = true;
+  }
+
+  // kept rows are filled in backwards, then reversed
+  std::vector<std::vector<int>> nodes;
+  std::vector<std::vector<Stencil>> stencils;
+
+  {
+    BOPM_TIME(Phase::Rollback);
+
+    // option values and node spots at steps i + 1 and i + 2, taken from the lattice's own rollback
+    std::vector<double> v1(n + 1), s1(n + 1), v2(n + 1), s2(n + 1);
+    rollback<double>(o, l, [&](const Slice<double> &s) {
+      if (stop.stop_requested()) {
+        throw Cancelled();
+      }
+
+      int i = s.step;
+      if (keep[i]) {
+        d.rows.push_back(i);
+        nodes.push_back(spaced(i, side));
+        stencils.emplace_back();
+
+        for (int j : nodes.back()) {
+          Stencil &t = stencils.back().emplace_back(Stencil{s.spot[j], s.value[j], {nan, nan}, {nan, nan}, {nan, nan, nan}, {nan, nan, nan}});
+          if (i < n) {
+            t.next_spot[0] = s1[j], t.next_spot[1] = s1[j + 1];
+            t.next_value[0] = v1[j], t.next_value[1] = v1[j + 1];
+          }
+          if (i + 2 <= n) {
+            nearest(s.spot[j], s2, v2, i + 2, t.later_spot, t.later_value);
+          }
+        }
+      }
+
+      std::swap(v2, v1);
+      std::swap(s2, s1);
+      std::copy(s.value, s.value + i + 1, v1.begin());
+      std::copy(s.spot, s.spot + i + 1, s1.begin());
+    });
+  }
+
+  BOPM_TIME(Phase::Greeks);
+
+  // delta one step on, theta two steps on at the node's own spot, none for path dependent options whose node
+  // values are not the option's
+  std::reverse(d.rows.begin(), d.rows.end());
+  d.offset.push_back(0);
+  for (int r = nodes.size() - 1; r >= 0; r--) {
+    d.node.insert(d.node.end(), nodes[r].begin(), nodes[r].end());
+    for (const Stencil &t : stencils[r]) {
+      d.spot.push_back(t.spot);
+      d.value.push_back(path ? nan : t.value);
+      d.delta.push_back(path ? nan : (t.next_value[1] - t.next_value[0]) / (t.next_spot[1] - t.next_spot[0]));
+      d.theta.push_back(path ? nan : (value_at(t.spot, t.later_spot, t.later_value) - t.value) / (2 * l.dt));
+    }
+    d.offset.push_back(d.node.size());
+  }
+
+  return d;
+}
+
+std::vector<std::vector<float>> plot_rows(const PlotData &d, const std::vector<float> &field) {
+  std::vector<std::vector<float>> rows;
+  for (size_t r = 0; r < d.rows.size(); r++) {
+    auto first = field.begin() + d.offset[r], last = field.begin() + d.offset[r + 1];
+    if (std::any_of(first, last, [](float x) { return !std::isnan(x); })) {
+      rows.emplace_back(first, last);
+    }
+  }
+  return rows;
+}
+
+nlohmann::json write_plot_data(const PlotData &d, const std::string &fn) {
+  BOPM_TIME(Phase::Serialise);
+
+  std::ofstream out(fn, std::ofstream::binary);
+  write(out, d.rows);
+  write(out, d.offset);
+  write(out, d.node);
+  write(out, d.spot);
+  write(out, d.value);
+  write(out, d.delta);
+  write(out, d.theta);
+
+  nlohmann::json meta;
+  meta["file"] = fn;
+  meta["steps"] = d.steps;
+  meta["strike"] = d.strike;
+  meta["arrays"] = {{"rows", "<i4", d.rows.size()},    {"offset", "<i4", d.offset.size()}, {"node", "<i4", d.node.size()},
+                    {"spot", "<f4", d.spot.size()},    {"value", "<f4", d.value.size()},   {"delta", "<f4", d.delta.size()},
+                    {"theta", "<f4", d.theta.size()}};
+
+  return meta;
+}
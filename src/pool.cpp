@@ -0,0 +1,206 @@
+#include "pool.hpp"
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+thread_local bool worker = false; // the calling thread is one of a pool's workers
+
+} // namespace
+
+std::vector<std::vector<int>> numa_nodes() {
+  std::vector<std::vector<int>> nodes;
+
+  // each node lists its cpus as ranges, e.g. 0-3,8-11
+  for (int n = 0;; n++) {
+    std::ifstream in(std::format("/sys/devices/system/node/node{}/cpulist", n));
+    if (!in) {
+      break;
+    }
+
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(in, range, ',')) {
+      int lo, hi;
+      char dash;
+      std::stringstream ss(range);
+      ss >> lo;
+      hi = ss >> dash >> hi ? hi : lo;
+      for (int c = lo; c <= hi; c++) {
+        cpus.push_back(c);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.push_back(cpus);
+    }
+  }
+
+  if (nodes.empty()) {
+    nodes.emplace_back();
+    for (int c = 0; c < (int)std::max(1u, std::thread::hardware_concurrency()); c++) {
+      nodes.back().push_back(c);
+    }
+  }
+
+  return nodes;
+}
+
+ThreadPool::ThreadPool(int threads, bool pin) {
+  // cpus in round robin order across nodes, so any number of workers is spread evenly, only those the process
+  // may run on (a cpuset or taskset can leave out most of the machine)
+  std::vector<std::vector<int>> nodes = numa_nodes();
+#if defined(__linux__)
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    for (auto &node : nodes) {
+      std::erase_if(node, [&](int c) { return c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed); });
+    }
+  }
+#endif
+
+  size_t cpus = 0;
+  for (auto &node : nodes) {
+    cpus += node.size();
+  }
+
+  std::vector<int> order;
+  for (size_t k = 0; order.size() < cpus; k++) {
+    for (auto &node : nodes) {
+      if (k < node.size()) {
+        order.push_back(node[k]);
+      }
+    }
+  }
+
+  // nothing left to pin to (the node lists and the affinity mask disagree), the workers run unpinned
+  if (order.empty()) {
+    pin = false;
+    order.push_back(-1);
+  }
+
+  if (threads <= 0) {
+    threads = cpus > 0 ? cpus : std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(&ThreadPool::work, this, pin ? order[t % order.size()] : -1);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(m);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &w : workers) {
+    w.join();
+  }
+}
+
+int ThreadPool::size() const { return workers.size(); }
+
+int ThreadPool::pinned() const { return pinned_workers; }
+
+void ThreadPool::work(int cpu) {
+#if defined(__linux__)
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    // on failure the worker keeps the affinity it inherited, and runs unpinned
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+      pinned_workers++;
+    }
+  }
+#endif
+
+  worker = true;
+
+  long seen = 0;
+  while (true) {
+    std::unique_lock lock(m);
+    wake.wait(lock, [&] { return stopping || generation != seen; });
+    if (stopping) {
+      return;
+    }
+    seen = generation;
+
+    while (next < total) {
+      size_t lo = next, hi = std::min(total, next + chunk);
+      next = hi;
+      const std::function<void(size_t)> &f = *job;
+      lock.unlock();
+
+      try {
+        for (size_t i = lo; i < hi; i++) {
+          f(i);
+        }
+      } catch (...) {
+        std::lock_guard guard(m);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+
+      lock.lock();
+      running -= hi - lo;
+    }
+
+    if (running == 0) {
+      finished.notify_all();
+    }
+  }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)> &f) {
+  if (n == 0) {
+    return;
+  }
+
+  if (worker) {
+    for (size_t i = 0; i < n; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  std::lock_guard serial(submit);
+  std::unique_lock lock(m);
+  job = &f;
+  total = n;
+  next = 0;
+  running = n;
+  error = nullptr;
+
+  // a few chunks per worker, small enough to balance uneven work, large enough to keep the lock quiet
+  chunk = std::max<size_t>(1, n / (workers.size() * 8));
+  generation++;
+  wake.notify_all();
+
+  finished.wait(lock, [&] { return running == 0; });
+  job = nullptr;
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+ThreadPool &ThreadPool::global() {
+  static ThreadPool pool;
+  return pool;
+}
+
+std::vector<float> price_batch(const std::vector<Option *> &options, ThreadPool &pool) {
+  std::vector<float> prices(options.size());
+  pool.parallel_for(options.size(), [&](size_t i) { prices[i] = options[i]->price(); });
+  return prices;
+}
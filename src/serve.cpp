@@ -0,0 +1,5 @@
+#include "service.hpp"
+#include <iostream>
+
+// headless pricing service over stdin/stdout, see service.hpp, links only the pricing core
+int main() { return serve(std::cin, std::cout); }
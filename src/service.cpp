@@ -0,0 +1,314 @@
+#include "service.hpp"
+#include "cache.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "planner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+TickQueue::TickQueue(size_t c) : capacity(c), merged(0) {}
+
+void TickQueue::push(Item item) {
+  std::unique_lock<std::mutex> guard(lock);
+
+  if (item.message.is_null()) {
+    auto it = pending.find(item.underlying);
+    if (it != pending.end()) {
+      it->second->spot = item.spot;
+      merged++;
+      return;
+    }
+  }
+
+  not_full.wait(guard, [&] { return items.size() < capacity; });
+  items.push_back(std::move(item));
+
+  // ticks only merge with ticks queued since the last other request, so an option added between two ticks
+  // is priced by the second
+  if (items.back().message.is_null()) {
+    pending[items.back().underlying] = std::prev(items.end());
+  } else {
+    pending.clear();
+  }
+
+  not_empty.notify_one();
+}
+
+TickQueue::Item TickQueue::pop() {
+  std::unique_lock<std::mutex> guard(lock);
+  not_empty.wait(guard, [&] { return !items.empty(); });
+
+  Item item = std::move(items.front());
+  if (item.message.is_null()) {
+    auto it = pending.find(item.underlying);
+    if (it != pending.end() && it->second == items.begin()) {
+      pending.erase(it);
+    }
+  }
+  items.pop_front();
+
+  not_full.notify_one();
+  return item;
+}
+
+long TickQueue::coalesced() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return merged;
+}
+
+LatencyStats::LatencyStats(size_t window) : samples(window), n(0) {}
+
+void LatencyStats::record(Clock::duration d) {
+  samples[n % samples.size()] = std::chrono::duration<float, std::micro>(d).count();
+  n++;
+}
+
+double LatencyStats::percentile(double p) const {
+  size_t size = std::min<size_t>(n, samples.size());
+  if (size == 0) {
+    return 0;
+  }
+
+  std::vector<float> sorted(samples.begin(), samples.begin() + size);
+  auto nth = sorted.begin() + std::min<size_t>(p * size, size - 1);
+  std::nth_element(sorted.begin(), nth, sorted.end());
+  return *nth;
+}
+
+long LatencyStats::count() const { return n; }
+
+PricingService::PricingService(std::ostream &o, size_t capacity) : out(o), queue(capacity), ticks(0) {
+  // the planner's throughput calibration is measured once per process, do it before any request arrives so
+  // the first one's latency doesn't include it
+  calibration();
+}
+
+void PricingService::run(std::istream &in) {
+  std::thread reader([&] { read(in); });
+
+  while (handle(queue.pop())) {
+  }
+
+  reader.join();
+}
+
+// parses requests on its own thread so the pricer never waits on input, ticks are timed from here
+void PricingService::read(std::istream &in) {
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+
+    TickQueue::Item item;
+    item.arrived = Clock::now();
+
+    try {
+      BOPM_TIME(Phase::Parse);
+      nlohmann::json request = nlohmann::json::parse(line);
+      if (request.value("op", "") == "tick") {
+        item.underlying = request.at("underlying");
+        item.spot = request.at("spot");
+      } else {
+        item.message = std::move(request);
+      }
+    } catch (const std::exception &e) {
+      emit({{"error", e.what()}});
+      continue;
+    }
+
+    bool quit = item.message.is_object() && item.message.value("op", "") == "quit";
+    queue.push(std::move(item));
+    if (quit) {
+      return;
+    }
+  }
+
+  // end of input, stop the pricer once it has drained the queue
+  queue.push({{{"op", "quit"}}, "", 0, Clock::now()});
+}
+
+bool PricingService::handle(const TickQueue::Item &item) {
+  std::string op = item.message.is_null() ? "tick" : item.message.value("op", "");
+
+  // option and remove requests answer errors under their id, so one bad request can be told apart from the rest
+  std::string id;
+  if (op == "option" || op == "remove") {
+    if (!item.message.contains("id") || !item.message.at("id").is_string()) {
+      emit({{"error", op + " request needs a string id"}});
+      return true;
+    }
+    id = item.message.at("id");
+  }
+
+  try {
+    if (op == "tick") {
+      reprice(item);
+    } else if (op == "option") {
+      add(id, item.message);
+    } else if (op == "remove") {
+      remove(id);
+    } else if (op == "stats") {
+      emit(stats());
+    } else if (op == "quit") {
+      emit(stats());
+      return false;
+    } else {
+      emit({{"error", "unknown op '" + op + "'"}});
+    }
+  } catch (const std::exception &e) {
+    if (id.empty()) {
+      emit({{"error", e.what()}});
+    } else {
+      emit({{"id", id}, {"error", e.what()}});
+    }
+  }
+
+  return true;
+}
+
+void PricingService::add(const std::string &id, const nlohmann::json &request) {
+  if (!request.contains("option") || !request.at("option").is_object() || !request.contains("model") ||
+      !request.at("model").is_object()) {
+    emit({{"id", id}, {"error", "option request needs an option and a model object"}});
+    return;
+  }
+  const nlohmann::json &data = request.at("option");
+
+  std::unique_ptr<Option> option;
+  std::string type = data.value("type", "");
+  if (type == "European") {
+    option = std::make_unique<EuropeanOption>();
+  } else if (type == "American") {
+    option = std::make_unique<AmericanOption>();
+  } else if (type == "Asian") {
+    option = std::make_unique<AsianOption>();
+  } else {
+    emit({{"id", id}, {"error", "unknown option type"}});
+    return;
+  }
+  option->from_json(data);
+
+  if (!(option->expiration > 0) || !(option->spot > 0) || !(option->strike > 0)) {
+    emit({{"id", id}, {"error", "option needs a positive spot, strike and expiration"}});
+    return;
+  }
+
+  // sizes are checked on the request itself, before anything is built from them
+  const nlohmann::json &model = request.at("model");
+  int steps = model.value("steps", 0);
+  if (steps < 1 || !model.contains("rates") || !model.at("rates").is_array() || !model.contains("volatilities") ||
+      !model.at("volatilities").is_array() || model.at("rates").size() < steps ||
+      model.at("volatilities").size() < steps) {
+    emit({{"id", id}, {"error", "model needs at least one step, and a rate and volatility for each step"}});
+    return;
+  }
+
+  // model steps are spread over the option's lifetime, as in the run pricing flow, so the request's dt (if any)
+  // is not used
+  option->model.from_json(model);
+  option->model.dt = option->expiration / option->model.steps;
+
+  const Model &m = option->model;
+  if (std::any_of(m.vols.begin(), m.vols.begin() + m.steps, [](float v) { return !(v > 0); })) {
+    emit({{"id", id}, {"error", "model volatilities must be positive"}});
+    return;
+  }
+
+  // every engine prices the spot less the cash dividends still to be paid, which has to stay positive
+  std::pmr::vector<double> scale, escrow;
+  dividend_adjustments(m, scale, escrow);
+  if (option->spot <= escrow[0]) {
+    emit({{"id", id}, {"error", "spot must be above the present value of the model's cash dividends"}});
+    return;
+  }
+
+  try {
+    check(*option);
+  } catch (const PlanError &e) {
+    emit({{"id", id}, {"error", e.what()}});
+    return;
+  }
+  if (option->type == Type::Asian) {
+    option->model.update_branches(); // only the asian walk prices off the branches
+  }
+
+  // an option that can't be priced now would only report the same on every tick, it is not stored (an option
+  // already under the id is kept)
+  float price = option->price();
+  if (!std::isfinite(price)) {
+    emit({{"id", id}, {"error", "option did not price to a finite value"}});
+    return;
+  }
+
+  remove(id);
+  by_underlying[option->underlying].push_back(id);
+  Option &o = *(options[id] = std::move(option));
+
+  emit({{"id", id}, {"price", price}, {"spot", o.spot}});
+}
+
+void PricingService::remove(const std::string &id) {
+  auto it = options.find(id);
+  if (it == options.end()) {
+    return;
+  }
+
+  std::vector<std::string> &ids = by_underlying[it->second->underlying];
+  ids.erase(std::find(ids.begin(), ids.end(), id));
+  options.erase(it);
+}
+
+void PricingService::reprice(const TickQueue::Item &tick) {
+  ticks++;
+
+  auto it = by_underlying.find(tick.underlying);
+  if (it == by_underlying.end() || it->second.empty()) {
+    return;
+  }
+
+  // an option that fails to price reports it under its id, the rest of the underlying still reprices
+  for (const std::string &id : it->second) {
+    Option &o = *options[id];
+    o.spot = tick.spot;
+    try {
+      emit({{"id", id}, {"price", o.price()}, {"spot", o.spot}});
+    } catch (const std::exception &e) {
+      emit({{"id", id}, {"error", e.what()}});
+    }
+  }
+
+  latency.record(Clock::now() - tick.arrived);
+}
+
+void PricingService::emit(const nlohmann::json &response) {
+  std::string line;
+  {
+    BOPM_TIME(Phase::Serialise);
+    line = response.dump();
+  }
+
+  std::lock_guard<std::mutex> guard(write_lock);
+  out << line << '\n' << std::flush;
+}
+
+nlohmann::json PricingService::stats() const {
+  return {{"ticks", ticks},
+          {"coalesced", queue.coalesced()},
+          {"priced", latency.count()},
+          {"p50_us", latency.percentile(0.5)},
+          {"p99_us", latency.percentile(0.99)},
+          {"options", options.size()},
+          {"cache", {{"hits", LatticeCache::global().hits()}, {"misses", LatticeCache::global().misses()}}},
+          {"instrumentation", instrument::to_json()}};
+}
+
+int serve(std::istream &in, std::ostream &out) {
+  // reading would otherwise flush out (std::cin is tied to std::cout) from the reader thread, racing the pricer
+  in.tie(nullptr);
+
+  PricingService service(out);
+  service.run(in);
+  return 0;
+}
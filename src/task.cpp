@@ -0,0 +1,84 @@
+#include "task.hpp"
+#include <chrono>
+
+Progress *&Progress::local() {
+  thread_local Progress *p = nullptr;
+  return p;
+}
+
+PricingTask::PricingTask(const Option &o, std::vector<int> s) : option(o.clone()), steps(std::move(s)) {
+  // only the asian walk prices off the branches, which can be large
+  if (option->type != Type::Asian) {
+    option->model.branches = {};
+  }
+
+  int n = option->model.steps;
+  if (steps.empty()) {
+    steps = {n / 4, n / 2, n};
+  }
+  std::erase_if(steps, [&](int k) { return k < 1 || k > n; });
+
+  for (int k : steps) {
+    prog.total += k;
+  }
+
+  worker = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+PricingTask::~PricingTask() { cancel(); }
+
+void PricingTask::run(std::stop_token stop) {
+  prog.stop = stop;
+  Progress::local() = &prog;
+
+  Model full = option->model;
+
+  try {
+    for (int k : steps) {
+      option->model = k == full.steps ? full : full.resample(k);
+      if (option->type == Type::Asian && k != full.steps) {
+        option->model.update_branches();
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      float price = option->price();
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+      std::lock_guard lock(m);
+      finished.push_back({k, price, elapsed.count()});
+    }
+  } catch (const Cancelled &) {
+    // finished refinements stand
+  } catch (...) {
+    std::lock_guard lock(m);
+    error = std::current_exception();
+  }
+
+  Progress::local() = nullptr;
+  over = true;
+}
+
+void PricingTask::cancel() { worker.request_stop(); }
+
+bool PricingTask::done() const { return over; }
+
+float PricingTask::progress() const { return prog.total > 0 ? std::min(1.f, (float)prog.done / prog.total) : 1; }
+
+std::vector<PricingTask::Result> PricingTask::results() const {
+  std::lock_guard lock(m);
+  return finished;
+}
+
+PricingTask::Result PricingTask::wait() {
+  if (worker.joinable()) {
+    worker.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  if (finished.empty()) {
+    throw Cancelled();
+  }
+  return finished.back();
+}
@@ -0,0 +1,117 @@
+#include "trinomial.hpp"
+#include "arena.hpp"
+#include "instrument.hpp"
+#include "lattice.hpp"
+#include "options.hpp"
+#include "task.hpp"
+#include <algorithm>
+#include <cmath>
+#include <experimental/simd>
+
+namespace stdx = std::experimental;
+using vfloat = stdx::native_simd<float>;
+
+Trinomial::Trinomial() {}
+
+Trinomial::Trinomial(const Model &m, std::pmr::memory_resource *mem)
+    : uProb(mem), mProb(mem), dProb(mem), disc(mem), scale(mem), escrow(mem), grid(mem) {
+  BOPM_TIME(Phase::Setup);
+
+  steps = m.steps;
+  dt = m.dt;
+
+  float vmax = *std::max_element(m.vols.begin(), m.vols.begin() + steps);
+  dx = vmax * std::sqrt(3 * dt);
+
+  uProb.resize(steps);
+  mProb.resize(steps);
+  dProb.resize(steps);
+  disc.resize(steps);
+  for (int i = 0; i < steps; i++) {
+    float nu = m.rates[i] - m.yield - m.vols[i] * m.vols[i] / 2; // drift of log spot
+    float var = (m.vols[i] * m.vols[i] * dt + nu * nu * dt * dt) / (dx * dx);
+
+    uProb[i] = (var + nu * dt / dx) / 2;
+    dProb[i] = (var - nu * dt / dx) / 2;
+    mProb[i] = 1 - uProb[i] - dProb[i];
+    disc[i] = std::exp(-m.rates[i] * dt);
+  }
+
+  std::pmr::vector<double> s(mem), e(mem);
+  dividend_adjustments(m, s, e);
+  scale.assign(s.begin(), s.end());
+  escrow.assign(e.begin(), e.end());
+
+  grid.resize(2 * steps + 1);
+  for (int k = 0; k <= 2 * steps; k++) {
+    grid[k] = std::exp((k - steps) * dx);
+  }
+}
+
+namespace {
+
+// backward induction specialised at compile time on exercise style and side (payout is max(Sign * (spot -
+// strike), 0)), so the simd loop carries no branches
+template <bool American, int Sign> float rollback_kernel(const Trinomial &t, float spot, float strike) {
+  float s0 = spot - t.escrow[0];
+
+  // option values at the expiration step
+  Arena &arena = Arena::local();
+  Arena::Scope scope(arena);
+
+  std::pmr::vector<float> v(2 * t.steps + 1, &arena);
+  for (int j = 0; j <= 2 * t.steps; j++) {
+    v[j] = std::max(Sign * (s0 * t.scale[t.steps] * t.grid[j] + t.escrow[t.steps] - strike), 0.f);
+  }
+
+  // work backwards, each node's children are j, j + 1 and j + 2 on the next step, so values can be
+  // overwritten in place in simd width chunks from the bottom up
+  for (int i = t.steps - 1; i >= 0; i--) {
+    Progress::step();
+
+    int nodes = 2 * i + 1;
+    const float *g = t.grid.data() + (t.steps - i); // grid offset so node j of step i is g[j]
+
+    vfloat pu = t.uProb[i], pm = t.mProb[i], pd = t.dProb[i], df = t.disc[i];
+    vfloat fac = s0 * t.scale[i], esc = t.escrow[i], k = strike;
+
+    int j = 0;
+    for (; j + (int)vfloat::size() <= nodes; j += vfloat::size()) {
+      vfloat lo(&v[j], stdx::element_aligned), mid(&v[j + 1], stdx::element_aligned), hi(&v[j + 2], stdx::element_aligned);
+      vfloat x = df * (pu * hi + pm * mid + pd * lo);
+
+      if constexpr (American) {
+        vfloat s = fac * vfloat(g + j, stdx::element_aligned) + esc;
+        x = stdx::max(x, vfloat(Sign) * (s - k));
+      }
+
+      x.copy_to(&v[j], stdx::element_aligned);
+    }
+
+    // remaining nodes that don't fill a simd register
+    for (; j < nodes; j++) {
+      v[j] = t.disc[i] * (t.uProb[i] * v[j + 2] + t.mProb[i] * v[j + 1] + t.dProb[i] * v[j]);
+
+      if constexpr (American) {
+        v[j] = std::max(v[j], Sign * (s0 * t.scale[i] * g[j] + t.escrow[i] - strike));
+      }
+    }
+  }
+
+  return v[0];
+}
+
+} // namespace
+
+float rollback(const Option &o, const Trinomial &t) {
+  BOPM_TIME(Phase::Rollback);
+  BOPM_COUNT(nodes, (t.steps + 1L) * (t.steps + 1));
+
+  // single dispatch to the specialised kernel
+  bool american = o.type == Type::American, call = o.side == Side::Call;
+  if (american) {
+    return call ? rollback_kernel<true, 1>(t, o.spot, o.strike) : rollback_kernel<true, -1>(t, o.spot, o.strike);
+  } else {
+    return call ? rollback_kernel<false, 1>(t, o.spot, o.strike) : rollback_kernel<false, -1>(t, o.spot, o.strike);
+  }
+}